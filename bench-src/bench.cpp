@@ -0,0 +1,355 @@
+// Single-host microbenchmarks for the ring implementations and the frame
+// codec, so a ring or codec change shows its cost in seconds instead of a
+// two-host NIC run via bench.zsh. Results go to stdout as CSV
+// (benchmark,cycles_per_op,mops) for analyze_results.py to track across
+// commits.
+//
+// Run with EAL args as usual; no port is needed, so --no-huge works for a
+// quick check: xmake run bench -- --no-huge -l 0-1
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdio>
+
+#include <rte_cycles.h>
+#include <rte_eal.h>
+#include <rte_ether.h>
+#include <rte_lcore.h>
+#include <rte_mbuf.h>
+#include <rte_memcpy.h>
+#include <rte_mempool.h>
+
+#include "common.hpp"
+#include "dpdk-rte-ring.hpp"
+#include "ring.hpp"
+#include "spsc-ring.hpp"
+#include "urp.hpp"
+
+static constexpr size_t RING_CAP = 1024;
+static constexpr uint32_t BURST = 32;
+static constexpr uint64_t NB_OPS = 1 << 20;
+static constexpr int WARMUP_TRIALS = 2;
+static constexpr int NB_TRIALS = 9;
+
+// Sink for results the optimizer must not discard
+static volatile uint64_t sink;
+
+// Run fn (which performs `ops` operations) NB_TRIALS times after discarded
+// warmup runs and report the median cycles/op — the median shrugs off the
+// odd scheduler blip that poisons an average
+template <typename F> static double measure(F &&fn, uint64_t ops) {
+  std::array<double, NB_TRIALS> samples;
+  for (int t = 0; t < WARMUP_TRIALS; ++t)
+    fn();
+  for (int t = 0; t < NB_TRIALS; ++t) {
+    uint64_t start = rte_get_timer_cycles();
+    fn();
+    samples[t] = (double)(rte_get_timer_cycles() - start) / (double)ops;
+  }
+  std::sort(samples.begin(), samples.end());
+  return samples[NB_TRIALS / 2];
+}
+
+static void report(const char *name, double cycles_per_op) {
+  double mops = rte_get_timer_hz() / cycles_per_op / 1e6;
+  printf("%s,%.2f,%.2f\n", name, cycles_per_op, mops);
+}
+
+// ---------------------------------------------------------------------------
+// Same-core ring ops: one push/pop (or one 32-burst) per "op"
+// ---------------------------------------------------------------------------
+
+static void bench_ring_same_core() {
+  static Ring<void *, RING_CAP> ring;
+  report("ring_single", measure(
+                            [] {
+                              void *item;
+                              for (uint64_t i = 0; i < NB_OPS; ++i) {
+                                ring.push((void *)(i + 1));
+                                ring.pop(item);
+                                sink = (uint64_t)item;
+                              }
+                            },
+                            NB_OPS));
+  // Ring has no burst API; a burst is just a run of pushes then pops, which
+  // is exactly how the protocol engines drive it
+  report("ring_burst32", measure(
+                             [] {
+                               void *item;
+                               for (uint64_t i = 0; i < NB_OPS; i += BURST) {
+                                 for (uint32_t j = 0; j < BURST; ++j)
+                                   ring.push((void *)(i + j + 1));
+                                 for (uint32_t j = 0; j < BURST; ++j)
+                                   ring.pop(item);
+                                 sink = (uint64_t)item;
+                               }
+                             },
+                             NB_OPS));
+}
+
+static void bench_spsc_same_core() {
+  static SpscRing<void *, RING_CAP> ring;
+  report("spsc_single", measure(
+                            [] {
+                              void *item;
+                              for (uint64_t i = 0; i < NB_OPS; ++i) {
+                                ring.push((void *)(i + 1));
+                                ring.pop(item);
+                                sink = (uint64_t)item;
+                              }
+                            },
+                            NB_OPS));
+  report("spsc_burst32", measure(
+                             [] {
+                               void *item;
+                               for (uint64_t i = 0; i < NB_OPS; i += BURST) {
+                                 for (uint32_t j = 0; j < BURST; ++j)
+                                   ring.push((void *)(i + j + 1));
+                                 for (uint32_t j = 0; j < BURST; ++j)
+                                   ring.pop(item);
+                                 sink = (uint64_t)item;
+                               }
+                             },
+                             NB_OPS));
+}
+
+static void bench_dpdk_ring_same_core() {
+  static srp::DpdkRteRing<uint64_t> *ring;
+  ring = new srp::DpdkRteRing<uint64_t>("bench_rte_ring", RING_CAP);
+  report("rte_ring_single", measure(
+                                [] {
+                                  uint64_t *item;
+                                  for (uint64_t i = 0; i < NB_OPS; ++i) {
+                                    ring->enqueue((uint64_t *)(i + 1));
+                                    ring->dequeue(item);
+                                    sink = (uint64_t)item;
+                                  }
+                                },
+                                NB_OPS));
+  report("rte_ring_burst32",
+         measure(
+             [] {
+               uint64_t *objs[BURST];
+               for (uint64_t i = 0; i < NB_OPS; i += BURST) {
+                 for (uint32_t j = 0; j < BURST; ++j)
+                   objs[j] = (uint64_t *)(i + j + 1);
+                 ring->enqueue_burst(objs, BURST);
+                 ring->dequeue_burst(objs, BURST);
+                 sink = (uint64_t)objs[BURST - 1];
+               }
+             },
+             NB_OPS));
+  delete ring;
+}
+
+// ---------------------------------------------------------------------------
+// Cross-core SPSC: producer on a remote lcore, consumer times the drain.
+// Ring is single-threaded by design, so it sits out this round.
+// ---------------------------------------------------------------------------
+
+static SpscRing<void *, RING_CAP> xc_spsc_ring;
+
+static int xc_spsc_producer(void *) {
+  for (uint64_t i = 0; i < NB_OPS;) {
+    if (xc_spsc_ring.push((void *)(i + 1)))
+      ++i;
+    else
+      rte_pause();
+  }
+  return 0;
+}
+
+static srp::DpdkRteRing<uint64_t> *xc_rte_ring;
+
+static int xc_rte_producer(void *) {
+  for (uint64_t i = 0; i < NB_OPS;) {
+    if (xc_rte_ring->enqueue((uint64_t *)(i + 1)))
+      ++i;
+    else
+      rte_pause();
+  }
+  return 0;
+}
+
+static void bench_cross_core(unsigned producer_lcore) {
+  report("spsc_cross_core", measure(
+                                [producer_lcore] {
+                                  rte_eal_remote_launch(xc_spsc_producer,
+                                                        nullptr, producer_lcore);
+                                  void *item;
+                                  for (uint64_t i = 0; i < NB_OPS;) {
+                                    if (xc_spsc_ring.pop(item)) {
+                                      sink = (uint64_t)item;
+                                      ++i;
+                                    } else {
+                                      rte_pause();
+                                    }
+                                  }
+                                  rte_eal_wait_lcore(producer_lcore);
+                                },
+                                NB_OPS));
+
+  xc_rte_ring = new srp::DpdkRteRing<uint64_t>("bench_rte_ring_xc", RING_CAP);
+  report("rte_ring_cross_core",
+         measure(
+             [producer_lcore] {
+               rte_eal_remote_launch(xc_rte_producer, nullptr, producer_lcore);
+               uint64_t *item;
+               for (uint64_t i = 0; i < NB_OPS;) {
+                 if (xc_rte_ring->dequeue(item)) {
+                   sink = (uint64_t)item;
+                   ++i;
+                 } else {
+                   rte_pause();
+                 }
+               }
+               rte_eal_wait_lcore(producer_lcore);
+             },
+             NB_OPS));
+  delete xc_rte_ring;
+}
+
+// ---------------------------------------------------------------------------
+// Frame codec against a dummy mempool — no port involved. The build/parse
+// helpers mirror URPEndpoint's header-template TX path and parse_frame so
+// the numbers track the real codec's cost.
+// ---------------------------------------------------------------------------
+
+static uint8_t hdr_template[sizeof(struct rte_ether_hdr) + sizeof(urp::urp_hdr)];
+
+static void init_hdr_template() {
+  struct rte_ether_hdr *eth = (struct rte_ether_hdr *)hdr_template;
+  memset(&eth->dst_addr, 0xff, sizeof(eth->dst_addr));
+  memset(&eth->src_addr, 0xaa, sizeof(eth->src_addr));
+  eth->ether_type = rte_cpu_to_be_16(urp::ETH_TYPE);
+  urp::urp_hdr *uh = (urp::urp_hdr *)(eth + 1);
+  uh->version = rte_cpu_to_be_16(1);
+  uh->opcode = rte_cpu_to_be_16(urp::OPCODE_DATA);
+  uh->payload_len = 0;
+  uh->msg_id = 0;
+  uh->frag_idx = 0;
+  uh->frag_total = rte_cpu_to_be_16(1);
+}
+
+static void build_frame(struct rte_mbuf *m, uint32_t seq,
+                        uint16_t payload_len) {
+  size_t frame_len =
+      sizeof(struct rte_ether_hdr) + sizeof(urp::urp_hdr) + payload_len;
+  uint8_t *p = rte_pktmbuf_mtod(m, uint8_t *);
+  rte_memcpy(p, hdr_template, sizeof(hdr_template));
+  urp::urp_hdr *uh = (urp::urp_hdr *)(p + sizeof(struct rte_ether_hdr));
+  uh->seq = rte_cpu_to_be_32(seq);
+  uh->payload_len = rte_cpu_to_be_16(payload_len);
+  m->data_len = (uint16_t)frame_len;
+  m->pkt_len = frame_len;
+}
+
+static uint64_t parse_frame(struct rte_mbuf *m) {
+  if (rte_pktmbuf_pkt_len(m) <
+      sizeof(struct rte_ether_hdr) + sizeof(urp::urp_hdr))
+    return 0;
+  struct rte_ether_hdr *eth = rte_pktmbuf_mtod(m, struct rte_ether_hdr *);
+  urp::urp_hdr *uh = (urp::urp_hdr *)(eth + 1);
+  bool ok = eth->ether_type == rte_cpu_to_be_16(urp::ETH_TYPE);
+  ok &= rte_be_to_cpu_16(uh->version) == 1;
+  uint16_t payload_len = rte_be_to_cpu_16(uh->payload_len);
+  ok &= payload_len <= urp::MAX_PAYLOAD;
+  if (!ok)
+    return 0;
+  return rte_be_to_cpu_32(uh->seq) + payload_len;
+}
+
+static void bench_frame_codec(struct rte_mempool *mbuf_pool) {
+  // Build: bulk alloc, write headers, bulk free — the mempool round trip is
+  // part of what the TX path pays per burst, so it stays in the measurement
+  report("frame_build32",
+         measure(
+             [mbuf_pool] {
+               struct rte_mbuf *bufs[BURST];
+               for (uint64_t i = 0; i < NB_OPS; i += BURST) {
+                 if (rte_pktmbuf_alloc_bulk(mbuf_pool, bufs, BURST) != 0)
+                   panic("bench mbuf alloc failed");
+                 for (uint32_t j = 0; j < BURST; ++j)
+                   build_frame(bufs[j], (uint32_t)(i + j), 64);
+                 rte_pktmbuf_free_bulk(bufs, BURST);
+               }
+             },
+             NB_OPS));
+
+  // Parse: decode a resident burst over and over; headers stay cache-hot,
+  // which isolates the decode cost from the memory system
+  struct rte_mbuf *bufs[BURST];
+  if (rte_pktmbuf_alloc_bulk(mbuf_pool, bufs, BURST) != 0)
+    panic("bench mbuf alloc failed");
+  for (uint32_t j = 0; j < BURST; ++j)
+    build_frame(bufs[j], j, 64);
+  report("frame_parse", measure(
+                            [&bufs] {
+                              uint64_t acc = 0;
+                              for (uint64_t i = 0; i < NB_OPS; i += BURST)
+                                for (uint32_t j = 0; j < BURST; ++j)
+                                  acc += parse_frame(bufs[j]);
+                              sink = acc;
+                            },
+                            NB_OPS));
+  rte_pktmbuf_free_bulk(bufs, BURST);
+}
+
+static void bench_payload_pool(struct rte_mempool *payload_pool) {
+  report("payload_single", measure(
+                               [payload_pool] {
+                                 void *obj;
+                                 for (uint64_t i = 0; i < NB_OPS; ++i) {
+                                   if (rte_mempool_get(payload_pool, &obj) < 0)
+                                     panic("bench payload alloc failed");
+                                   rte_mempool_put(payload_pool, obj);
+                                 }
+                               },
+                               NB_OPS));
+  report("payload_bulk32",
+         measure(
+             [payload_pool] {
+               void *objs[BURST];
+               for (uint64_t i = 0; i < NB_OPS; i += BURST) {
+                 if (rte_mempool_get_bulk(payload_pool, objs, BURST) < 0)
+                   panic("bench payload bulk alloc failed");
+                 rte_mempool_put_bulk(payload_pool, objs, BURST);
+               }
+             },
+             NB_OPS));
+}
+
+int main(int argc, char **argv) {
+  int ret = rte_eal_init(argc, argv);
+  if (ret < 0)
+    panic("Failed to initialize EAL");
+
+  unsigned producer_lcore = rte_get_next_lcore(rte_lcore_id(), 1, 0);
+  if (producer_lcore == RTE_MAX_LCORE)
+    panic("bench needs two lcores (e.g. -l 0-1) for the cross-core runs");
+
+  struct rte_mempool *mbuf_pool = rte_pktmbuf_pool_create(
+      "bench_mbuf", 4096, 256, 0, RTE_MBUF_DEFAULT_BUF_SIZE, rte_socket_id());
+  if (!mbuf_pool)
+    panic("Failed to create bench mbuf pool");
+  struct rte_mempool *payload_pool =
+      rte_mempool_create("bench_payload", 8192 - 1, sizeof(urp::Payload), 256,
+                         0, NULL, NULL, NULL, NULL, rte_socket_id(), 0);
+  if (!payload_pool)
+    panic("Failed to create bench payload pool");
+
+  init_hdr_template();
+
+  printf("benchmark,cycles_per_op,mops\n");
+  bench_ring_same_core();
+  bench_spsc_same_core();
+  bench_dpdk_ring_same_core();
+  bench_cross_core(producer_lcore);
+  bench_frame_codec(mbuf_pool);
+  bench_payload_pool(payload_pool);
+
+  rte_mempool_free(payload_pool);
+  rte_mempool_free(mbuf_pool);
+  rte_eal_cleanup();
+  return 0;
+}
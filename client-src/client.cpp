@@ -5,14 +5,66 @@
 #include <rte_eal.h>
 #include <rte_ether.h>
 #include <rte_ring.h>
+#include <sstream>
+#include <string>
 #include <thread>
 
 #include "arg.hpp"
+#include "backoff.hpp"
+#include "numa.hpp"
+#include "stats.hpp"
 #include "urp.hpp"
 #include <argparse/argparse.hpp>
 
 using namespace urp;
 
+// Token-bucket paced enqueue: tokens accrue against the TSC at rate_pps and
+// each packet spends one, so bursts are released on schedule instead of as
+// fast as the ring accepts (under full blast, queueing delay swamps the RTT
+// the payload timestamps measure). Runs for duration_cycles (0 = forever)
+// and returns the achieved packets/sec.
+static double run_paced(URPEndpoint *ep, Payload **payloads, uint64_t rate_pps,
+                        uint64_t duration_cycles) {
+  rte_ring *out = ep->outbound_ring();
+  const double tokens_per_cycle = (double)rate_pps / rte_get_tsc_hz();
+  // Cap the bucket at one TX burst so a stall cannot release a megaburst
+  const double bucket_cap = ep->cfg().tx_burst_size;
+  double tokens = 0;
+  uint64_t start = rte_get_tsc_cycles();
+  uint64_t last = start;
+  uint64_t sent = 0;
+  uint32_t idx = 0;
+  for (;;) {
+    uint64_t now = rte_get_tsc_cycles();
+    if (duration_cycles && now - start >= duration_cycles)
+      break;
+    tokens += (double)(now - last) * tokens_per_cycle;
+    if (tokens > bucket_cap)
+      tokens = bucket_cap;
+    last = now;
+    if (tokens < 1) {
+      rte_pause();
+      continue;
+    }
+    uint32_t n = (uint32_t)tokens;
+    for (uint32_t j = 0; j < n; ++j) {
+      Payload *rec = payloads[idx++ % 1024];
+      // Embed send timestamp (TSC cycles) for latency measurement; the PTP
+      // wire stamp is written by the TX side (see fill_data_frame), since
+      // staged Payload bytes never reach the wire on this path
+      uint64_t tsc = rte_get_tsc_cycles();
+      rte_memcpy(rec->data, &tsc, sizeof(tsc));
+      while (rte_ring_sp_enqueue(out, rec) == -ENOBUFS) {
+        rte_pause();
+      }
+    }
+    tokens -= n;
+    sent += n;
+  }
+  uint64_t elapsed = rte_get_tsc_cycles() - start;
+  return elapsed ? (double)sent * rte_get_tsc_hz() / elapsed : 0;
+}
+
 static int producer_thread_main(void *arg) {
   URPEndpoint *ep = reinterpret_cast<URPEndpoint *>(arg);
   rte_ring *out = ep->outbound_ring();
@@ -25,15 +77,64 @@ static int producer_thread_main(void *arg) {
   Payload *payloads[1024] = {};
 
   for (uint32_t i = 0; i < 1024; ++i) {
-    payloads[i] =
-        (Payload *)rte_zmalloc(NULL, sizeof(Payload), RTE_CACHE_LINE_SIZE);
-
+    payloads[i] = ep->payload_alloc();
+    if (!payloads[i])
+      rte_exit(EXIT_FAILURE, "Failed to allocate producer payloads\n");
     payloads[i]->size = ep->cfg().unit_size;
   }
 
+  const EndpointConfig cfg = ep->cfg();
+  uint64_t rate_pps = cfg.rate_pps;
+  if (cfg.rate_gbps > 0) {
+    // Convert from line rate: pace on the full wire frame for this unit size
+    size_t frame_bytes =
+        sizeof(struct rte_ether_hdr) + sizeof(urp_hdr) + cfg.unit_size;
+    rate_pps = (uint64_t)(cfg.rate_gbps * 1e9 / 8.0 / frame_bytes);
+  }
+
+  if (!cfg.rate_sweep.empty()) {
+    // Walk the rate list for the latency-vs-offered-load curve; the stats
+    // reporter interleaves per-step latency percentiles with these lines
+    uint64_t step = (uint64_t)cfg.sweep_secs * rte_get_tsc_hz();
+    std::stringstream rates(cfg.rate_sweep);
+    std::string tok;
+    while (std::getline(rates, tok, ',')) {
+      uint64_t rate = std::stoull(tok);
+      double achieved = run_paced(ep, payloads, rate, step);
+      printf("sweep_rate:%" PRIu64 " achieved_pps:%.0f\n", rate, achieved);
+    }
+    printf("rate sweep complete\n");
+    return 0;
+  }
+
+  if (rate_pps > 0) {
+    run_paced(ep, payloads, rate_pps, 0);
+    return 0;
+  }
+
+  if (cfg.inline_size && cfg.unit_size <= cfg.inline_size) {
+    // Small-message fast path: the bytes travel in the ring slots, so no
+    // Payload allocation or pointer chase per record (paced/sweep runs keep
+    // pointer mode for comparability)
+    uint8_t rec[urp::MAX_PAYLOAD];
+    for (;;) {
+      uint64_t tsc = rte_get_tsc_cycles();
+      rte_memcpy(rec, &tsc, sizeof(tsc));
+      if (cfg.hw_timestamp && cfg.unit_size >= 16) {
+        uint64_t ns = ep->ptp_time_ns();
+        rte_memcpy(rec + 8, &ns, sizeof(ns));
+      }
+      while (!ep->send_inline(rec, cfg.unit_size))
+        rte_pause();
+    }
+    return 0;
+  }
+
   for (;;) {
     Payload *rec = payloads[i % 1024];
-    // Embed send timestamp (TSC cycles) for latency measurement
+    // Embed send timestamp (TSC cycles) for latency measurement. No PTP
+    // stamp here: staged Payload bytes never reach the wire on this path,
+    // so the TX side stamps the frame itself (see fill_data_frame)
     uint64_t tsc = rte_get_tsc_cycles();
     rte_memcpy(rec->data, &tsc, sizeof(tsc));
     while (rte_ring_sp_enqueue(out, rec) == -ENOBUFS) {
@@ -62,20 +163,54 @@ static int producer_thread_main(void *arg) {
   return 0;
 }
 
-static int tx_thread_main(void *arg) {
+// Zero-copy producer: writes message bytes straight into mbuf payload
+// regions via tx_prepare()/tx_commit(), replacing the producer + TX thread
+// pair (no Payload staging, no outbound ring transition)
+static int zc_producer_thread_main(void *arg) {
   URPEndpoint *ep = reinterpret_cast<URPEndpoint *>(arg);
-  printf("TX thread running on lcore %u\n", rte_lcore_id());
+  uint16_t payload_len = (uint16_t)ep->cfg().unit_size;
+  uint32_t burst = ep->cfg().tx_burst_size;
+  printf("ZC producer thread running on lcore %u\n", rte_lcore_id());
+  for (;;) {
+    uint16_t n = ep->tx_prepare(burst, payload_len);
+    if (n == 0) {
+      rte_pause();
+      continue;
+    }
+    auto regions = ep->tx_regions();
+    for (uint16_t i = 0; i < n; ++i) {
+      // Embed send timestamp (TSC cycles) for latency measurement
+      uint64_t tsc = rte_get_tsc_cycles();
+      rte_memcpy(regions[i], &tsc, sizeof(tsc));
+    }
+    ep->tx_commit(n);
+  }
+  return 0;
+}
+
+struct QueueWorkerArg {
+  URPEndpoint *ep;
+  uint16_t queue_id;
+};
+
+static int tx_thread_main(void *arg) {
+  QueueWorkerArg *wa = reinterpret_cast<QueueWorkerArg *>(arg);
+  printf("TX thread for queue %u running on lcore %u\n", wa->queue_id,
+         rte_lcore_id());
+  IdleBackoff backoff(wa->ep->cfg().adaptive_poll);
   for (;;) {
-    ep->tx();
+    backoff.poll(wa->ep->tx(wa->queue_id) != 0);
   }
   return 0;
 }
 
 static int rx_thread_main(void *arg) {
-  URPEndpoint *ep = reinterpret_cast<URPEndpoint *>(arg);
-  printf("RX thread running on lcore %u\n", rte_lcore_id());
+  QueueWorkerArg *wa = reinterpret_cast<QueueWorkerArg *>(arg);
+  printf("RX thread for queue %u running on lcore %u\n", wa->queue_id,
+         rte_lcore_id());
+  IdleBackoff backoff(wa->ep->cfg().adaptive_poll);
   for (;;) {
-    ep->rx();
+    backoff.poll(wa->ep->rx(wa->queue_id) != 0);
   }
   return 0;
 }
@@ -104,52 +239,74 @@ int main(int argc, char **argv) {
   if (!ep)
     return 1;
 
-  unsigned tx_lcore = rte_get_next_lcore(rte_lcore_id(), 1, 0);
-  if (tx_lcore == RTE_MAX_LCORE) {
-    rte_exit(EXIT_FAILURE, "Not enough cores\n");
+  // Launch one TX and one RX worker per queue pair; in zero-copy TX mode the
+  // producer owns the TX queue directly, so skip the TX workers
+  static QueueWorkerArg worker_args[RTE_MAX_QUEUES_PER_PORT];
+  // Keep the workers on the NIC's node; next_lcore_on_socket warns when it
+  // has to spill onto the far socket
+  int socket = port_socket_id(cfg.port_id);
+  unsigned lcore = rte_lcore_id();
+  for (uint16_t q = 0; q < cfg.nb_queues; ++q) {
+    worker_args[q] = {ep, q};
+    if (!cfg.zero_copy_tx) {
+      lcore = next_lcore_on_socket(lcore, socket);
+      if (lcore == RTE_MAX_LCORE) {
+        rte_exit(EXIT_FAILURE, "Not enough cores\n");
+      }
+      rte_eal_remote_launch((lcore_function_t *)tx_thread_main, &worker_args[q],
+                            lcore);
+    }
+    lcore = next_lcore_on_socket(lcore, socket);
+    if (lcore == RTE_MAX_LCORE) {
+      rte_exit(EXIT_FAILURE, "Not enough cores\n");
+    }
+    rte_eal_remote_launch((lcore_function_t *)rx_thread_main, &worker_args[q],
+                          lcore);
   }
-  rte_eal_remote_launch((lcore_function_t *)tx_thread_main, ep, tx_lcore);
-
-  unsigned rx_lcore = rte_get_next_lcore(tx_lcore, 1, 0);
-  rte_eal_remote_launch((lcore_function_t *)rx_thread_main, ep, rx_lcore);
 
   // Launch producer on a separate lcore
-  unsigned producer_lcore = rte_get_next_lcore(rx_lcore, 1, 0);
+  unsigned producer_lcore = next_lcore_on_socket(lcore, socket);
   if (producer_lcore == RTE_MAX_LCORE) {
     rte_exit(EXIT_FAILURE, "Not enough cores\n");
   }
-  rte_eal_remote_launch((lcore_function_t *)producer_thread_main,
+  rte_eal_remote_launch((lcore_function_t *)(cfg.zero_copy_tx
+                                                 ? zc_producer_thread_main
+                                                 : producer_thread_main),
                         ep, producer_lcore);
 
+  // Reporter aggregates the per-lcore stats blocks off the hot path
+  stats::start_reporter("client_stats.csv");
+
   // Optionally consume inbound DATA if server also sends
-  uint64_t count = 0;
-  long double rtt_sum_us = 0.0L;
-  const uint64_t report_interval = 100000;
-  uint64_t last_time = 0;
+  IdleBackoff backoff(cfg.adaptive_poll);
   for (;;) {
-    Payload *msg = nullptr;
-    if (rte_ring_sc_dequeue(ep->inbound_ring(), (void **)&msg) == 0) {
-      // Compute RTT latency using embedded TSC timestamp
-      count++;
-      if (msg->size > 0) {
-        uint64_t send_tsc = 0;
-        rte_memcpy(&send_tsc, msg->data, sizeof(send_tsc));
-        uint64_t now = rte_get_tsc_cycles();
-        uint64_t diff = now - send_tsc;
-        double us = (double)diff * 1e6 / (double)rte_get_tsc_hz();
-        rtt_sum_us += us;
-      }
-
-      if (count % report_interval == 0) {
-        auto now = rte_get_tsc_cycles();
-        double seconds = (now - last_time) / (double)rte_get_tsc_hz();
-        // report throughput in Mbps
-        double throughput = (double)(report_interval) / seconds;
-        printf("Throughput: %.2f\n", throughput);
-        rtt_sum_us = 0.0L;
-        last_time = now;
+    void *obj = nullptr;
+    stats::LcoreStats &ls = stats::local();
+    if (rte_ring_sc_dequeue(ep->inbound_ring(), &obj) == 0) {
+      // Record RTT from the embedded TSC timestamp into the histogram so the
+      // reporter can print p50/p99/p999 instead of a discarded average
+      if (cfg.zero_copy_rx) {
+        // In this mode the ring slots hold rte_mbuf*; read the payload in
+        // place, then hand the mbuf back to the RX pool
+        struct rte_mbuf *m = (struct rte_mbuf *)obj;
+        auto payload = URPEndpoint::payload_view(m);
+        if (payload.size() >= sizeof(uint64_t)) {
+          uint64_t send_tsc = 0;
+          rte_memcpy(&send_tsc, payload.data(), sizeof(send_tsc));
+          ls.rtt_cycles.record(rte_get_tsc_cycles() - send_tsc);
+        }
+        URPEndpoint::rx_release(&m, 1);
+      } else {
+        Payload *msg = (Payload *)obj;
+        if (msg->size > 0) {
+          uint64_t send_tsc = 0;
+          rte_memcpy(&send_tsc, msg->data, sizeof(send_tsc));
+          ls.rtt_cycles.record(rte_get_tsc_cycles() - send_tsc);
+        }
       }
+      backoff.poll(true);
     } else {
+      backoff.poll(false);
     }
   }
 
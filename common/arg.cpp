@@ -11,6 +11,12 @@ void parse_args(int argc, char **argv, urp::EndpointConfig &cfg) {
       .action(
           [&](const std::string &value) { cfg.port_id = std::stoi(value); });
 
+  parser.add_argument("-q", "--queues")
+      .help("Number of RX/TX queue pairs")
+      .default_value(1)
+      .action(
+          [&](const std::string &value) { cfg.nb_queues = std::stoi(value); });
+
   parser.add_argument("-tx", "--tx-burst")
       .help("TX burst size")
       .default_value(128)
@@ -25,6 +31,118 @@ void parse_args(int argc, char **argv, urp::EndpointConfig &cfg) {
         cfg.rx_burst_size = std::stoi(value);
       });
 
+  parser.add_argument("--mtu")
+      .help("Link MTU (e.g. 9000 for jumbo frames)")
+      .default_value(1500)
+      .action([&](const std::string &value) { cfg.mtu = std::stoi(value); });
+
+  parser.add_argument("--zc-tx")
+      .help("Zero-copy TX: producer writes directly into mbuf payloads")
+      .default_value(false)
+      .implicit_value(true)
+      .action([&](const auto &) { cfg.zero_copy_tx = true; });
+
+  parser.add_argument("--zc-rx")
+      .help("Zero-copy RX: deliver mbufs in place, free via rx_release")
+      .default_value(false)
+      .implicit_value(true)
+      .action([&](const auto &) { cfg.zero_copy_rx = true; });
+
+  parser.add_argument("--inline")
+      .help("Pass payloads up to N bytes inline through the ring slots "
+            "(0 = pointer mode)")
+      .default_value(0)
+      .action([&](const std::string &value) {
+        cfg.inline_size = std::stoul(value);
+      });
+
+  parser.add_argument("--adaptive-poll")
+      .help("Back off to short sleeps when the link is idle")
+      .default_value(false)
+      .implicit_value(true)
+      .action([&](const auto &) { cfg.adaptive_poll = true; });
+
+  parser.add_argument("--hw-timestamp")
+      .help("Enable IEEE 1588 NIC timestamping for wire-latency reporting")
+      .default_value(false)
+      .implicit_value(true)
+      .action([&](const auto &) { cfg.hw_timestamp = true; });
+
+  parser.add_argument("--rate")
+      .help("Target offered load in packets/sec (0 = unpaced)")
+      .default_value(0)
+      .action(
+          [&](const std::string &value) { cfg.rate_pps = std::stoull(value); });
+
+  parser.add_argument("--rate-gbps")
+      .help("Target offered load in Gbps (converted from the frame size)")
+      .default_value(0.0)
+      .action(
+          [&](const std::string &value) { cfg.rate_gbps = std::stod(value); });
+
+  parser.add_argument("--rate-sweep")
+      .help("Comma-separated pps list; run each rate for --sweep-secs")
+      .default_value(std::string{})
+      .action([&](const std::string &value) { cfg.rate_sweep = value; });
+
+  parser.add_argument("--sweep-secs")
+      .help("Seconds to spend at each rate of --rate-sweep")
+      .default_value(5)
+      .action([&](const std::string &value) {
+        cfg.sweep_secs = std::stoi(value);
+      });
+
+  parser.add_argument("--drop")
+      .help("Impairment: per-frame drop probability, e.g. 0.01")
+      .default_value(0.0)
+      .action([&](const std::string &value) {
+        cfg.impair.drop_prob = std::stod(value);
+      });
+
+  parser.add_argument("--dup")
+      .help("Impairment: per-frame duplication probability")
+      .default_value(0.0)
+      .action([&](const std::string &value) {
+        cfg.impair.dup_prob = std::stod(value);
+      });
+
+  parser.add_argument("--reorder")
+      .help("Impairment: per-frame reorder probability")
+      .default_value(0.0)
+      .action([&](const std::string &value) {
+        cfg.impair.reorder_prob = std::stod(value);
+      });
+
+  parser.add_argument("--reorder-dist")
+      .help("Impairment: frames a reordered frame is held behind")
+      .default_value(8)
+      .action([&](const std::string &value) {
+        cfg.impair.reorder_dist = std::stoul(value);
+      });
+
+  parser.add_argument("--impair-seed")
+      .help("Impairment PRNG seed; same seed replays the same pattern")
+      .default_value(0)
+      .action([&](const std::string &value) {
+        uint64_t seed = std::stoull(value);
+        if (seed)
+          cfg.impair.seed = seed;
+      });
+
+  parser.add_argument("--event-pipeline")
+      .help("Run stages as rte_eventdev events balanced across worker "
+            "lcores instead of the fixed thread topology")
+      .default_value(false)
+      .implicit_value(true)
+      .action([&](const auto &) { cfg.event_pipeline = true; });
+
+  parser.add_argument("--event-workers")
+      .help("Worker lcores for --event-pipeline (0 = all remaining)")
+      .default_value(0)
+      .action([&](const std::string &value) {
+        cfg.nb_event_workers = std::stoi(value);
+      });
+
   parser.add_argument("-s", "--size")
       .help("Size of the cache")
       .default_value(0)
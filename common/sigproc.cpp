@@ -3,6 +3,9 @@
 #include <cstring>
 #include <rte_ethdev.h>
 
+#include "backoff.hpp"
+#include "flow.hpp"
+#include "numa.hpp"
 #include "sigproc.hpp"
 
 namespace sigproc {
@@ -26,7 +29,14 @@ static inline int port_init(uint16_t port_id, struct rte_mempool *pool) {
   ret = rte_eth_dev_start(port_id);
   if (ret < 0)
     return ret;
-  rte_eth_promiscuous_enable(port_id);
+  // Steer the signaling EtherType in the NIC; promiscuous mode is only the
+  // fallback for PMDs without rte_flow support
+  if (!flow_steer_ether_type(port_id, SIG_ETHER_TYPE)) {
+    printf("port %u: rte_flow steering unavailable, "
+           "falling back to promiscuous mode\n",
+           port_id);
+    rte_eth_promiscuous_enable(port_id);
+  }
   return 0;
 }
 
@@ -44,7 +54,9 @@ SigEndpoint *SigEndpoint::start(const EndpointConfig &cfg) {
     delete ep;
     return nullptr;
   }
-  unsigned lcore = rte_get_next_lcore(rte_lcore_id(), 1, 0);
+  // Run the engine on the NIC's node so its polling never crosses sockets
+  unsigned lcore =
+      next_lcore_on_socket(rte_lcore_id(), port_socket_id(cfg.port_id));
   if (lcore == RTE_MAX_LCORE) {
     delete ep;
     return nullptr;
@@ -58,11 +70,26 @@ void SigEndpoint::stop() { running_ = false; }
 bool SigEndpoint::init_dpdk() {
   if (!rte_eth_dev_is_valid_port(cfg_.port_id))
     return false;
+  // Place everything the NIC DMAs into — and the rings the engine polls —
+  // on the NIC's node, not the node of whichever core runs init
+  int socket = port_socket_id(cfg_.port_id);
   mbuf_pool_ =
       rte_pktmbuf_pool_create("SIGPROC_POOL", NB_MBUF, MBUF_CACHE_SIZE, 0,
-                              RTE_MBUF_DEFAULT_BUF_SIZE, rte_socket_id());
+                              RTE_MBUF_DEFAULT_BUF_SIZE, socket);
   if (!mbuf_pool_)
     return false;
+  char send_pool_name[64];
+  char recv_pool_name[64];
+  snprintf(send_pool_name, sizeof(send_pool_name), "sig_send_%u", cfg_.port_id);
+  snprintf(recv_pool_name, sizeof(recv_pool_name), "sig_recv_%u", cfg_.port_id);
+  send_pool_ = rte_mempool_create(send_pool_name, NB_MBUF - 1, sizeof(SigSend),
+                                  MBUF_CACHE_SIZE, 0, NULL, NULL, NULL, NULL,
+                                  socket, 0);
+  recv_pool_ = rte_mempool_create(recv_pool_name, NB_MBUF - 1, sizeof(SigRecv),
+                                  MBUF_CACHE_SIZE, 0, NULL, NULL, NULL, NULL,
+                                  socket, 0);
+  if (!send_pool_ || !recv_pool_)
+    return false;
   if (port_init(cfg_.port_id, mbuf_pool_) < 0)
     return false;
   rte_eth_macaddr_get(cfg_.port_id, &src_mac_);
@@ -71,9 +98,9 @@ bool SigEndpoint::init_dpdk() {
   char out_name[64];
   snprintf(in_name, sizeof(in_name), "sig_in_%u", cfg_.port_id);
   snprintf(out_name, sizeof(out_name), "sig_out_%u", cfg_.port_id);
-  inbound_ring_ = rte_ring_create(in_name, cfg_.ring_size, rte_socket_id(),
+  inbound_ring_ = rte_ring_create(in_name, cfg_.ring_size, socket,
                                   RING_F_SP_ENQ | RING_F_SC_DEQ);
-  outbound_ring_ = rte_ring_create(out_name, cfg_.ring_size, rte_socket_id(),
+  outbound_ring_ = rte_ring_create(out_name, cfg_.ring_size, socket,
                                    RING_F_SP_ENQ | RING_F_SC_DEQ);
   if (!inbound_ring_ || !outbound_ring_)
     return false;
@@ -86,57 +113,79 @@ int SigEndpoint::engine_main(void *arg) {
 }
 
 
-void SigEndpoint::tx(EngineState &st) {
-  // TX: if nothing pending, pull from outbound ring and send; else retransmit
-  // on timeout
-  if (!st.pending.has_pending) {
-    SigSend *rec = nullptr;
-    if (rte_ring_sc_dequeue(outbound_ring_, (void **)&rec) == 0) {
-      uint16_t ch = rec->channel_id;
-      uint32_t seq = st.next_seq[ch]++;
-      const rte_ether_addr *dst =
-          st.have_learned_peer ? &st.learned_peer : &peer_mac_default_;
-      struct rte_mbuf *m =
-          build_data_frame(mbuf_pool_, &src_mac_, dst, rec, seq);
-      if (m) {
-        uint16_t s = rte_eth_tx_burst(cfg_.port_id, 0, &m, 1);
-        if (s == 0) {
-          rte_pktmbuf_free(m);
-        } else {
-          st.pending.has_pending = true;
-          st.pending.channel_id = ch;
-          st.pending.seq = seq;
-          st.pending.last_tx_cycles = rte_get_timer_cycles();
-          st.pending.send_copy = *rec;
-        }
-      }
-      rte_free(rec);
-    } else {
-      rte_pause();
+uint16_t SigEndpoint::tx(EngineState &st) {
+  const rte_ether_addr *dst =
+      st.have_learned_peer ? &st.learned_peer : &peer_mac_default_;
+  uint64_t now = rte_get_timer_cycles();
+
+  // Retransmit: rebuild every expired slot's frame and burst them together.
+  // MAX_OUTSTANDING is small enough that a linear scan stays in L1; a timer
+  // wheel would only pay off with a much deeper window.
+  uint16_t nb_retx = 0;
+  for (uint16_t i = 0; i < MAX_OUTSTANDING && nb_retx < BURST_SIZE; ++i) {
+    EngineState::Pending &slot = st.slots[i];
+    if (!slot.in_use || now - slot.last_tx_cycles < st.timeout_cycles)
+      continue;
+    struct rte_mbuf *m =
+        build_data_frame(mbuf_pool_, &src_mac_, dst, &slot.send_copy, slot.seq);
+    if (m) {
+      st.tx_bufs[nb_retx++] = m;
+      slot.last_tx_cycles = now;
     }
-  } else {
-    uint64_t now = rte_get_timer_cycles();
-    if (now - st.pending.last_tx_cycles >= st.timeout_cycles) {
-      const rte_ether_addr *dst =
-          st.have_learned_peer ? &st.learned_peer : &peer_mac_default_;
-      struct rte_mbuf *m = build_data_frame(
-          mbuf_pool_, &src_mac_, dst, &st.pending.send_copy, st.pending.seq);
-      if (m) {
-        uint16_t s = rte_eth_tx_burst(cfg_.port_id, 0, &m, 1);
-        if (s == 0) {
-          rte_pktmbuf_free(m);
-        } else {
-          st.pending.last_tx_cycles = now;
-        }
-      }
-    } else {
-      rte_pause();
+  }
+  if (nb_retx > 0) {
+    uint16_t s = rte_eth_tx_burst(cfg_.port_id, 0, st.tx_bufs, nb_retx);
+    if (s < nb_retx)
+      rte_pktmbuf_free_bulk(st.tx_bufs + s, nb_retx - s);
+  }
+
+  // Fill free slots with new messages: burst dequeue, build all frames, one
+  // tx_burst. A frame the NIC did not take this round is covered by the
+  // retransmit scan above.
+  uint16_t free_slots = MAX_OUTSTANDING - st.nb_outstanding;
+  uint16_t want = free_slots < BURST_SIZE ? free_slots : BURST_SIZE;
+  if (want == 0) {
+    rte_pause();
+    return nb_retx;
+  }
+  unsigned nb = rte_ring_sc_dequeue_burst(outbound_ring_, (void **)st.tx_recs,
+                                          want, nullptr);
+  if (nb == 0) {
+    rte_pause();
+    return nb_retx;
+  }
+
+  uint16_t nb_built = 0;
+  uint16_t slot_idx = 0;
+  for (unsigned i = 0; i < nb; ++i) {
+    SigSend *rec = st.tx_recs[i];
+    uint16_t ch = rec->channel_id;
+    uint32_t seq = st.flows.lookup(ch)->next_seq++;
+    struct rte_mbuf *m = build_data_frame(mbuf_pool_, &src_mac_, dst, rec, seq);
+    if (m) {
+      while (st.slots[slot_idx].in_use)
+        ++slot_idx;
+      EngineState::Pending &slot = st.slots[slot_idx];
+      slot.in_use = true;
+      slot.channel_id = ch;
+      slot.seq = seq;
+      slot.last_tx_cycles = now;
+      slot.send_copy = *rec;
+      st.nb_outstanding++;
+      st.tx_bufs[nb_built++] = m;
     }
+    send_free(rec);
+  }
+  if (nb_built > 0) {
+    uint16_t s = rte_eth_tx_burst(cfg_.port_id, 0, st.tx_bufs, nb_built);
+    if (s < nb_built)
+      rte_pktmbuf_free_bulk(st.tx_bufs + s, nb_built - s);
   }
+  return (uint16_t)(nb_retx + nb_built);
 }
 
 
-void SigEndpoint::rx(EngineState &st) {
+uint16_t SigEndpoint::rx(EngineState &st) {
   // RX first: handle ACKs and inbound DATA; send ACKs for DATA
   uint16_t nb_rx = rte_eth_rx_burst(cfg_.port_id, 0, st.rx_bufs, BURST_SIZE);
   for (uint16_t i = 0; i < nb_rx; ++i) {
@@ -150,15 +199,19 @@ void SigEndpoint::rx(EngineState &st) {
       st.have_learned_peer = true;
 
       if (rcv.opcode == SIG_OPCODE_ACK) {
-        if (st.pending.has_pending && rcv.channel_id == st.pending.channel_id &&
-            rcv.seq == st.pending.seq) {
-          st.pending.has_pending = false;
+        for (uint16_t s = 0; s < MAX_OUTSTANDING; ++s) {
+          if (st.slots[s].in_use && rcv.channel_id == st.slots[s].channel_id &&
+              rcv.seq == st.slots[s].seq) {
+            st.slots[s].in_use = false;
+            st.nb_outstanding--;
+            break;
+          }
         }
       } else {
         // Enqueue inbound DATA only if in-order
-        uint32_t expect = st.expect_seq[rcv.channel_id];
-        if (rcv.seq == expect) {
-          st.expect_seq[rcv.channel_id] = expect + 1;
+        FlowTable::Entry *flow = st.flows.lookup(rcv.channel_id);
+        if (rcv.seq == flow->expect_seq) {
+          flow->expect_seq++;
           // ACK back
           const rte_ether_addr *dst =
               st.have_learned_peer ? &st.learned_peer : &peer_mac_default_;
@@ -170,8 +223,7 @@ void SigEndpoint::rx(EngineState &st) {
               rte_pktmbuf_free(ack);
           }
           // Copy and deliver
-          SigRecv *copy = (SigRecv *)rte_zmalloc(NULL, sizeof(SigRecv),
-                                                 RTE_CACHE_LINE_SIZE);
+          SigRecv *copy = recv_alloc();
           if (copy) {
             *copy = rcv;
             while (rte_ring_sp_enqueue(inbound_ring_, copy) == -ENOBUFS) {
@@ -182,22 +234,25 @@ void SigEndpoint::rx(EngineState &st) {
     }
     rte_pktmbuf_free(m);
   }
+  return nb_rx;
 }
 
 int SigEndpoint::run_loop() {
   EngineState st{};
   st.ep = this;
-  memset(st.next_seq, 0, sizeof(st.next_seq));
-  memset(st.expect_seq, 0, sizeof(st.expect_seq));
   st.timeout_cycles = cfg_.retransmit_timeout_cycles;
   if (st.timeout_cycles == 0)
     st.timeout_cycles = rte_get_timer_hz() / 10;
 
   struct rte_mbuf *rx_bufs[BURST_SIZE];
 
+  // Idle backoff keeps an idle engine off 100% CPU; any moved frame snaps
+  // it back to hard polling
+  IdleBackoff backoff(cfg_.adaptive_poll);
   while (running_) {
-    rx(st);
-    tx(st);
+    uint16_t moved = rx(st);
+    moved = (uint16_t)(moved + tx(st));
+    backoff.poll(moved != 0);
   }
 
   return 0;
@@ -0,0 +1,50 @@
+// backoff.hpp - adaptive idle backoff for the polling loops
+#pragma once
+
+#include <cstdint>
+#include <rte_cycles.h>
+#include <rte_pause.h>
+
+#include "stats.hpp"
+
+// Escalating idle backoff: hard-poll through rte_pause for the first
+// SPIN_LIMIT consecutive empty polls, then sleep in rte_delay_us_sleep steps
+// that double up to MAX_SLEEP_US. The first nonempty poll snaps straight
+// back to hard polling, so latency under load is untouched; the cost shows
+// up only in the empty_poll_ratio the stats reporter already prints.
+class IdleBackoff {
+public:
+  explicit IdleBackoff(bool enabled = true) : enabled_(enabled) {}
+
+  // Call once per loop iteration; did_work is whether the poll moved
+  // anything
+  void poll(bool did_work) {
+    stats::LcoreStats &ls = stats::local();
+    ls.polls++;
+    if (did_work) {
+      idle_ = 0;
+      sleep_us_ = 0;
+      return;
+    }
+    ls.empty_polls++;
+    if (!enabled_)
+      return;
+    if (++idle_ <= SPIN_LIMIT) {
+      rte_pause();
+      return;
+    }
+    if (sleep_us_ == 0)
+      sleep_us_ = 1;
+    else if (sleep_us_ < MAX_SLEEP_US)
+      sleep_us_ *= 2;
+    rte_delay_us_sleep(sleep_us_);
+  }
+
+private:
+  static constexpr uint32_t SPIN_LIMIT = 1024;
+  static constexpr uint32_t MAX_SLEEP_US = 256;
+
+  bool enabled_;
+  uint32_t idle_ = 0;
+  uint32_t sleep_us_ = 0;
+};
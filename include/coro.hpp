@@ -0,0 +1,218 @@
+// coro.hpp - cooperative coroutine layer over URPEndpoint
+//
+// The spin-loop model dedicates an lcore per function (client.cpp burns four
+// for one endpoint); on a 16-core edge box that leaves nothing for several
+// endpoints plus application logic. This layer multiplexes many application
+// coroutines and endpoint progress loops on one lcore:
+//
+//   urp::Task echo(urp::URPEndpoint *ep) {
+//     for (;;) {
+//       void *msg = co_await urp::recv(*ep);   // Payload* (Message*/mbuf*
+//       ...                                     // for fragments / zc mode)
+//       co_await urp::send(*ep, payload);
+//     }
+//   }
+//   urp::Scheduler sched;
+//   sched.add_endpoint(ep);
+//   sched.spawn(echo(ep));
+//   sched.run(running);
+//
+// Suspension is a handle push onto a ring and resumption an indirect call —
+// tens of ns — so awaiting per message costs far less than the message.
+#pragma once
+
+#include <coroutine>
+#include <cstdint>
+#include <rte_lcore.h>
+#include <rte_ring.h>
+#include <vector>
+
+#include "common.hpp"
+#include "ring.hpp"
+#include "urp.hpp"
+
+namespace urp {
+
+class Scheduler;
+
+// One scheduler per lcore, installed for the duration of run() (same idiom
+// as stats::g_lcore_stats)
+inline Scheduler *g_lcore_scheduler[RTE_MAX_LCORE];
+
+// A coroutine parked on a condition; the scheduler re-polls try_complete
+// each loop and resumes the handle once it returns true. Function pointer
+// instead of a vtable: awaiters are short-lived stack objects.
+struct Waiter {
+  std::coroutine_handle<> handle;
+  bool (*try_complete)(Waiter *w);
+  Waiter *next{nullptr};
+};
+
+// Fire-and-forget coroutine task. Starts suspended (the scheduler resumes
+// it); the frame frees itself on completion, so the scheduler never touches
+// a finished handle.
+class Task {
+public:
+  struct promise_type {
+    Scheduler *sched{nullptr};
+    ~promise_type();
+
+    Task get_return_object() {
+      return Task{std::coroutine_handle<promise_type>::from_promise(*this)};
+    }
+    std::suspend_always initial_suspend() noexcept { return {}; }
+    std::suspend_never final_suspend() noexcept { return {}; }
+    void return_void() {}
+    void unhandled_exception() { panic("Unhandled exception in coroutine"); }
+  };
+
+  explicit Task(std::coroutine_handle<promise_type> h) : handle(h) {}
+  std::coroutine_handle<promise_type> handle;
+};
+
+// Per-lcore cooperative round-robin scheduler. Each loop iteration drives
+// the registered endpoints' progress(), resumes every ready coroutine once,
+// and re-polls parked waiters. Single-threaded by design, like QueueBufs:
+// one scheduler per lcore, no locks anywhere.
+class Scheduler {
+public:
+  static constexpr size_t MAX_READY = 1024;
+
+  Scheduler() = default;
+
+  // Non-copyable
+  Scheduler(const Scheduler &) = delete;
+  Scheduler &operator=(const Scheduler &) = delete;
+
+  static Scheduler &current() {
+    Scheduler *s = g_lcore_scheduler[rte_lcore_id()];
+    if (!s)
+      panic("No scheduler running on lcore %u", rte_lcore_id());
+    return *s;
+  }
+
+  // Endpoints whose progress() this scheduler drives between resumptions
+  void add_endpoint(URPEndpoint *ep) { endpoints_.push_back(ep); }
+
+  void spawn(Task t) {
+    t.handle.promise().sched = this;
+    ++nb_tasks_;
+    schedule(t.handle);
+  }
+
+  void schedule(std::coroutine_handle<> h) {
+    if (!ready_.push(h))
+      panic("Scheduler ready ring full (%zu tasks)", (size_t)MAX_READY);
+  }
+
+  void park(Waiter *w) {
+    w->next = waiters_;
+    waiters_ = w;
+  }
+
+  // Run until the flag clears or every spawned task has finished
+  void run(volatile bool &running) {
+    g_lcore_scheduler[rte_lcore_id()] = this;
+    while (running && nb_tasks_ > 0) {
+      for (auto *ep : endpoints_)
+        ep->progress();
+
+      // Resume what was ready at the start of the pass; anything a resumed
+      // coroutine schedules runs next pass
+      std::size_t n = ready_.size();
+      std::coroutine_handle<> h;
+      for (std::size_t i = 0; i < n && ready_.pop(h); ++i)
+        h.resume();
+
+      // Detach the parked list and re-poll it; waiters that stay blocked
+      // (and any new ones a resumed coroutine parks) go back on the list
+      Waiter *w = waiters_;
+      waiters_ = nullptr;
+      while (w) {
+        Waiter *next = w->next;
+        if (w->try_complete(w))
+          w->handle.resume();
+        else
+          park(w);
+        w = next;
+      }
+    }
+    g_lcore_scheduler[rte_lcore_id()] = nullptr;
+  }
+
+private:
+  friend struct Task::promise_type;
+
+  Ring<std::coroutine_handle<>, MAX_READY> ready_;
+  Waiter *waiters_{nullptr};
+  std::vector<URPEndpoint *> endpoints_;
+  uint32_t nb_tasks_{0};
+};
+
+inline Task::promise_type::~promise_type() {
+  if (sched)
+    --sched->nb_tasks_;
+}
+
+// co_await recv(ep): suspends until the inbound ring yields an entry.
+// Entries are Payload* in the default mode, Message* for reassembled
+// fragments, rte_mbuf* under zero-copy RX — same contract as the raw ring.
+struct RecvAwaiter : Waiter {
+  URPEndpoint *ep;
+  void *obj{nullptr};
+
+  static bool poll(Waiter *w) {
+    RecvAwaiter *self = (RecvAwaiter *)w;
+    return rte_ring_dequeue(self->ep->inbound_ring(), &self->obj) == 0;
+  }
+
+  explicit RecvAwaiter(URPEndpoint &e) : ep(&e) { try_complete = &poll; }
+  bool await_ready() { return poll(this); }
+  void await_suspend(std::coroutine_handle<> h) {
+    handle = h;
+    Scheduler::current().park(this);
+  }
+  void *await_resume() { return obj; }
+};
+
+inline RecvAwaiter recv(URPEndpoint &ep) { return RecvAwaiter{ep}; }
+
+// co_await send(ep, payload): suspends until the outbound ring accepts the
+// payload — backpressure from a full ring parks the coroutine instead of
+// spinning the lcore
+struct SendAwaiter : Waiter {
+  URPEndpoint *ep;
+  Payload *payload;
+
+  static bool poll(Waiter *w) {
+    SendAwaiter *self = (SendAwaiter *)w;
+    return rte_ring_enqueue(self->ep->outbound_ring(), self->payload) == 0;
+  }
+
+  SendAwaiter(URPEndpoint &e, Payload *p) : ep(&e), payload(p) {
+    try_complete = &poll;
+  }
+  bool await_ready() { return poll(this); }
+  void await_suspend(std::coroutine_handle<> h) {
+    handle = h;
+    Scheduler::current().park(this);
+  }
+  void await_resume() {}
+};
+
+inline SendAwaiter send(URPEndpoint &ep, Payload *p) {
+  return SendAwaiter{ep, p};
+}
+
+// co_await yield(): give the rest of the lcore a turn and resume next pass
+struct YieldAwaiter {
+  bool await_ready() noexcept { return false; }
+  void await_suspend(std::coroutine_handle<> h) {
+    Scheduler::current().schedule(h);
+  }
+  void await_resume() noexcept {}
+};
+
+inline YieldAwaiter yield() { return YieldAwaiter{}; }
+
+} // namespace urp
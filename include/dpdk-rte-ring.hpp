@@ -1,11 +1,13 @@
 // Header-only typed wrapper around DPDK rte_ring for single-producer, single-consumer use
 #pragma once
 
+#include <span>
 #include <stdexcept>
 #include <string>
 #include <type_traits>
 
 #include <rte_ring.h>
+#include <rte_ring_peek_zc.h>
 
 namespace srp {
 
@@ -37,18 +39,28 @@ public:
     }
   }
 
+  // Non-owning view of a ring owned elsewhere (e.g. by an endpoint); the
+  // wrapper will not free it
+  static DpdkRteRing view(rte_ring *existing) {
+    DpdkRteRing r(existing);
+    r.owned_ = false;
+    return r;
+  }
+
   ~DpdkRteRing() { reset(); }
 
   DpdkRteRing(const DpdkRteRing &) = delete;
   DpdkRteRing &operator=(const DpdkRteRing &) = delete;
 
-  DpdkRteRing(DpdkRteRing &&other) noexcept : ring_(other.ring_) {
+  DpdkRteRing(DpdkRteRing &&other) noexcept
+      : ring_(other.ring_), owned_(other.owned_) {
     other.ring_ = nullptr;
   }
   DpdkRteRing &operator=(DpdkRteRing &&other) noexcept {
     if (this != &other) {
       reset();
       ring_ = other.ring_;
+      owned_ = other.owned_;
       other.ring_ = nullptr;
     }
     return *this;
@@ -56,7 +68,8 @@ public:
 
   void reset() noexcept {
     if (ring_ != nullptr) {
-      rte_ring_free(ring_);
+      if (owned_)
+        rte_ring_free(ring_);
       ring_ = nullptr;
     }
   }
@@ -100,6 +113,43 @@ public:
                                      count, nullptr);
   }
 
+  // Zero-copy access: reserve ring slots and read/write the T* entries in
+  // place instead of staging through local arrays. A ring wraps at the end of
+  // its storage, so the reserved slots come back as (up to) two typed spans.
+  struct ZcView {
+    rte_ring_zc_data zcd{};
+    unsigned n{0}; // slots actually reserved
+
+    std::span<T *> span1() noexcept {
+      unsigned n1 = n < zcd.n1 ? n : zcd.n1;
+      return std::span<T *>(reinterpret_cast<T **>(zcd.ptr1), n1);
+    }
+    std::span<T *> span2() noexcept {
+      unsigned n1 = n < zcd.n1 ? n : zcd.n1;
+      return std::span<T *>(reinterpret_cast<T **>(zcd.ptr2), n - n1);
+    }
+  };
+
+  // Reserve up to count occupied slots for in-place consumption; finish with
+  // zc_dequeue_finish(n_consumed)
+  unsigned zc_dequeue_start(unsigned count, ZcView &view) noexcept {
+    view.n = rte_ring_dequeue_zc_burst_start(ring_, count, &view.zcd, nullptr);
+    return view.n;
+  }
+  void zc_dequeue_finish(unsigned count) noexcept {
+    rte_ring_dequeue_zc_finish(ring_, count);
+  }
+
+  // Reserve up to count free slots for in-place production; write the
+  // pointers into the spans, then zc_enqueue_finish(n_written)
+  unsigned zc_enqueue_start(unsigned count, ZcView &view) noexcept {
+    view.n = rte_ring_enqueue_zc_burst_start(ring_, count, &view.zcd, nullptr);
+    return view.n;
+  }
+  void zc_enqueue_finish(unsigned count) noexcept {
+    rte_ring_enqueue_zc_finish(ring_, count);
+  }
+
   [[nodiscard]] unsigned count() const noexcept {
     return rte_ring_count(ring_);
   }
@@ -112,6 +162,7 @@ public:
 
 private:
   rte_ring *ring_ = nullptr;
+  bool owned_ = true;
 };
 
 }  // namespace srp
\ No newline at end of file
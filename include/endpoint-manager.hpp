@@ -0,0 +1,86 @@
+// endpoint-manager.hpp - one process driving several URP endpoints
+#pragma once
+
+#include <rte_eal.h>
+#include <rte_lcore.h>
+#include <vector>
+
+#include "backoff.hpp"
+#include "common.hpp"
+#include "numa.hpp"
+#include "urp.hpp"
+
+namespace urp {
+
+// Owns one URPEndpoint per configured port, assigns each a worker lcore on
+// its NIC's node, and drives the progress() loops there. This is what lets
+// one process serve two NICs — or both ends of a loopback benchmark —
+// without paying a second EAL process's hugepage footprint; endpoint
+// resource names already carry the port id, so nothing collides.
+class EndpointManager {
+public:
+  explicit EndpointManager(const std::vector<EndpointConfig> &cfgs) {
+    for (const auto &cfg : cfgs)
+      endpoints_.push_back(new URPEndpoint(cfg));
+    workers_.reserve(endpoints_.size());
+  }
+
+  // Non-copyable
+  EndpointManager(const EndpointManager &) = delete;
+  EndpointManager &operator=(const EndpointManager &) = delete;
+
+  ~EndpointManager() {
+    stop();
+    // Join the workers before freeing what they poll: stop() only raises
+    // the flag, and a worker can still be inside ep->progress() when the
+    // endpoint goes away
+    for (const auto &w : workers_)
+      rte_eal_wait_lcore(w.lcore);
+    for (auto *ep : endpoints_)
+      delete ep;
+  }
+
+  size_t size() const { return endpoints_.size(); }
+  URPEndpoint *endpoint(size_t i) { return endpoints_[i]; }
+
+  // Launch one progress() worker per endpoint, each on its NIC's node
+  void start() {
+    unsigned lcore = rte_lcore_id();
+    for (auto *ep : endpoints_) {
+      lcore = next_lcore_on_socket(lcore, port_socket_id(ep->cfg().port_id));
+      if (lcore == RTE_MAX_LCORE)
+        panic("Not enough lcores for %zu endpoints", endpoints_.size());
+      workers_.push_back({ep, this, lcore});
+      rte_eal_remote_launch((lcore_function_t *)worker_main, &workers_.back(),
+                            lcore);
+    }
+  }
+
+  // Stop the workers (best-effort); they notice on their next iteration
+  void stop() { running_ = false; }
+
+private:
+  struct Worker {
+    URPEndpoint *ep;
+    EndpointManager *mgr;
+    // Lcore the worker was launched on, so teardown can join it
+    unsigned lcore;
+  };
+
+  static int worker_main(void *arg) {
+    Worker *w = reinterpret_cast<Worker *>(arg);
+    printf("Endpoint worker for port %u running on lcore %u\n",
+           w->ep->cfg().port_id, rte_lcore_id());
+    IdleBackoff backoff(w->ep->cfg().adaptive_poll);
+    while (w->mgr->running_) {
+      backoff.poll(w->ep->progress() != 0);
+    }
+    return 0;
+  }
+
+  std::vector<URPEndpoint *> endpoints_;
+  std::vector<Worker> workers_;
+  volatile bool running_{true};
+};
+
+} // namespace urp
@@ -0,0 +1,296 @@
+// event-pipeline.hpp - event-driven execution mode on rte_eventdev
+//
+// The fixed server topology (dedicated tx/rx/responder lcores wired up in
+// main) makes load imbalance structural: at small payloads the RX lcore
+// saturates while the responder idles, and rebalancing means editing code.
+// Here RX bursts become events on an rte_eventdev instead: a thin injector
+// polls the NIC and enqueues each frame as a NEW event, and the parse and
+// application stages are event handlers that any worker lcore can pick up,
+// so adding a worker is a core-count change and stage-level balancing is
+// the scheduler's job. Atomic scheduling keyed on the frame's msg_id (seq
+// for unfragmented traffic) serializes each flow through a stage, so
+// per-flow ordering survives the parallelism.
+//
+// Works with hardware event devices or the software PMD
+// (--vdev event_sw0); for the latter the injector also drives the
+// scheduler service, so no extra service lcore is needed.
+#pragma once
+
+#include <rte_ethdev.h>
+#include <rte_eventdev.h>
+#include <rte_lcore.h>
+#include <rte_mbuf.h>
+#include <rte_service.h>
+
+#include "backoff.hpp"
+#include "common.hpp"
+#include "numa.hpp"
+#include "stats.hpp"
+#include "urp.hpp"
+
+namespace urp {
+
+class EventPipeline {
+public:
+  explicit EventPipeline(const EndpointConfig &cfg) : cfg_(cfg) {
+    // Elastic by default: every lcore not taken by main or the injector
+    // becomes a pipeline worker
+    nb_workers_ = cfg.nb_event_workers
+                      ? cfg.nb_event_workers
+                      : (rte_lcore_count() > 2 ? rte_lcore_count() - 2 : 1);
+
+    max_payload_ = cfg.max_payload ? cfg.max_payload
+                                   : (size_t)cfg.mtu - sizeof(urp_hdr);
+
+    uint16_t buf_size = (uint16_t)RTE_ALIGN_CEIL(
+        RTE_PKTMBUF_HEADROOM + RTE_ETHER_HDR_LEN + cfg.mtu,
+        RTE_CACHE_LINE_SIZE);
+    if (buf_size < RTE_MBUF_DEFAULT_BUF_SIZE)
+      buf_size = RTE_MBUF_DEFAULT_BUF_SIZE;
+
+    int socket = port_socket_id(cfg.port_id);
+    char pool_name[64];
+    snprintf(pool_name, sizeof(pool_name), "evp_mbuf_%u", cfg.port_id);
+    mbuf_pool_ = rte_pktmbuf_pool_create(pool_name, 2048, 128, 0, buf_size,
+                                         socket);
+    if (!mbuf_pool_)
+      panic("Failed to create event pipeline mbuf pool");
+
+    // One RX queue (the injector is the only poller) but a TX queue per
+    // worker, so the application stage transmits without serializing
+    port_init(cfg.port_id, mbuf_pool_, 1, cfg.flow_steering, cfg.mtu, false,
+              cfg.tx_fast_free, nb_workers_);
+
+    setup_eventdev(socket);
+  }
+
+  ~EventPipeline() {
+    rte_event_dev_stop(dev_id_);
+    rte_event_dev_close(dev_id_);
+    rte_mempool_free(mbuf_pool_);
+  }
+
+  // Launch the injector and the workers on remote lcores; the caller keeps
+  // the main lcore for the stats reporter
+  void start() {
+    int socket = port_socket_id(cfg_.port_id);
+    unsigned lcore = next_lcore_on_socket(rte_lcore_id(), socket);
+    if (lcore == RTE_MAX_LCORE)
+      panic("Not enough cores for the event pipeline injector");
+    rte_eal_remote_launch((lcore_function_t *)injector_main, this, lcore);
+
+    for (uint16_t w = 0; w < nb_workers_; ++w) {
+      // Event port 0 belongs to the injector; workers take 1..nb_workers
+      worker_args_[w] = {this, (uint8_t)(1 + w), w};
+      lcore = next_lcore_on_socket(lcore, socket);
+      if (lcore == RTE_MAX_LCORE)
+        panic("Not enough cores for %u pipeline workers", nb_workers_);
+      rte_eal_remote_launch((lcore_function_t *)worker_main, &worker_args_[w],
+                            lcore);
+      printf("Pipeline worker %u on lcore %u (event port %u, tx queue %u)\n",
+             w, lcore, 1 + w, w);
+    }
+  }
+
+private:
+  // Stage queues; both atomic so the scheduler holds each flow on one
+  // worker until the stage releases it
+  static constexpr uint8_t STAGE_PARSE = 0;
+  static constexpr uint8_t STAGE_APP = 1;
+  static constexpr uint16_t MAX_WORKERS = 64;
+
+  struct WorkerArg {
+    EventPipeline *pipe;
+    uint8_t ev_port;
+    uint16_t tx_queue;
+  };
+
+  void setup_eventdev(int socket) {
+    if (rte_event_dev_count() == 0)
+      panic("No event device; start with --vdev event_sw0 for the software "
+            "scheduler");
+    dev_id_ = 0;
+    if (nb_workers_ > MAX_WORKERS)
+      panic("%u pipeline workers exceeds %u", nb_workers_,
+            (unsigned)MAX_WORKERS);
+
+    struct rte_event_dev_info info{};
+    rte_event_dev_info_get(dev_id_, &info);
+
+    struct rte_event_dev_config dev_conf{};
+    dev_conf.nb_event_queues = 2;
+    dev_conf.nb_event_ports = (uint8_t)(1 + nb_workers_);
+    dev_conf.nb_events_limit = RTE_MIN(info.max_num_events, 4096);
+    dev_conf.nb_event_queue_flows = 1024;
+    dev_conf.nb_event_port_dequeue_depth =
+        RTE_MIN((uint32_t)info.max_event_port_dequeue_depth,
+                (uint32_t)DEFAULT_BURST_SIZE);
+    dev_conf.nb_event_port_enqueue_depth =
+        RTE_MIN((uint32_t)info.max_event_port_enqueue_depth,
+                (uint32_t)DEFAULT_BURST_SIZE);
+    dev_conf.dequeue_timeout_ns = 0;
+    if (rte_event_dev_configure(dev_id_, &dev_conf) < 0)
+      panic("Failed to configure event device %u", dev_id_);
+
+    struct rte_event_queue_conf q_conf{};
+    q_conf.schedule_type = RTE_SCHED_TYPE_ATOMIC;
+    q_conf.priority = RTE_EVENT_DEV_PRIORITY_NORMAL;
+    q_conf.nb_atomic_flows = 1024;
+    for (uint8_t q = 0; q < 2; ++q) {
+      if (rte_event_queue_setup(dev_id_, q, &q_conf) < 0)
+        panic("Failed to setup event queue %u", q);
+    }
+
+    struct rte_event_port_conf p_conf{};
+    rte_event_port_default_conf_get(dev_id_, 0, &p_conf);
+    for (uint8_t p = 0; p < 1 + nb_workers_; ++p) {
+      if (rte_event_port_setup(dev_id_, p, &p_conf) < 0)
+        panic("Failed to setup event port %u", p);
+      // The injector port only enqueues NEW events; worker ports link to
+      // every stage queue so any worker can run any stage
+      if (p > 0 && rte_event_port_link(dev_id_, p, nullptr, nullptr, 0) < 0)
+        panic("Failed to link event port %u", p);
+    }
+
+    // The software PMD schedules from a service; run it from the injector
+    // loop instead of dedicating a service lcore
+    if (rte_event_dev_service_id_get(dev_id_, &sched_service_) == 0) {
+      has_sched_service_ = true;
+      rte_service_runstate_set(sched_service_, 1);
+      rte_service_set_runstate_mapped_check(sched_service_, 0);
+    }
+
+    if (rte_event_dev_start(dev_id_) < 0)
+      panic("Failed to start event device %u", dev_id_);
+  }
+
+  // Flow key for atomic scheduling: fragments of one message share its
+  // msg_id and must stay ordered; unfragmented frames key on seq, which
+  // still serializes a retransmitted frame against its duplicate
+  static uint32_t flow_id_of(struct rte_mbuf *m) {
+    urp_hdr *uh = rte_pktmbuf_mtod_offset(m, urp_hdr *,
+                                          sizeof(struct rte_ether_hdr));
+    uint32_t msg_id = rte_be_to_cpu_32(uh->msg_id);
+    return msg_id ? msg_id : rte_be_to_cpu_32(uh->seq);
+  }
+
+  // RX injector: the only stage tied to a core, and deliberately thin — one
+  // burst in, one enqueue out, no per-frame work beyond the flow key
+  static int injector_main(void *arg) {
+    EventPipeline *pipe = (EventPipeline *)arg;
+    printf("Pipeline injector running on lcore %u\n", rte_lcore_id());
+    struct rte_mbuf *bufs[DEFAULT_BURST_SIZE];
+    struct rte_event evs[DEFAULT_BURST_SIZE];
+    IdleBackoff backoff(pipe->cfg_.adaptive_poll);
+    for (;;) {
+      if (pipe->has_sched_service_)
+        rte_service_run_iter_on_app_lcore(pipe->sched_service_, 1);
+
+      uint16_t nb_rx = rte_eth_rx_burst(pipe->cfg_.port_id, 0, bufs,
+                                        DEFAULT_BURST_SIZE);
+      if (nb_rx == 0) {
+        backoff.poll(false);
+        continue;
+      }
+      for (uint16_t i = 0; i < nb_rx; ++i) {
+        evs[i] = rte_event{};
+        evs[i].flow_id = flow_id_of(bufs[i]);
+        evs[i].op = RTE_EVENT_OP_NEW;
+        evs[i].sched_type = RTE_SCHED_TYPE_ATOMIC;
+        evs[i].queue_id = STAGE_PARSE;
+        evs[i].event_type = RTE_EVENT_TYPE_ETHDEV;
+        evs[i].mbuf = bufs[i];
+      }
+      uint16_t sent = 0;
+      while (sent < nb_rx) {
+        sent += rte_event_enqueue_new_burst(pipe->dev_id_, 0, evs + sent,
+                                            nb_rx - sent);
+        if (sent < nb_rx && pipe->has_sched_service_)
+          // Backpressure: the scheduler is behind, give it a turn
+          rte_service_run_iter_on_app_lcore(pipe->sched_service_, 1);
+      }
+      backoff.poll(true);
+    }
+    return 0;
+  }
+
+  // Parse stage: validate the frame in place; good frames forward to the
+  // application stage under the same flow, bad ones free and release
+  void stage_parse(struct rte_event &ev) {
+    struct rte_mbuf *m = ev.mbuf;
+    bool ok = rte_pktmbuf_pkt_len(m) >=
+              sizeof(struct rte_ether_hdr) + sizeof(urp_hdr);
+    if (ok) {
+      struct rte_ether_hdr *eth = rte_pktmbuf_mtod(m, struct rte_ether_hdr *);
+      urp_hdr *uh = (urp_hdr *)(eth + 1);
+      ok = eth->ether_type == rte_cpu_to_be_16(ETH_TYPE);
+      ok &= rte_be_to_cpu_16(uh->version) == 1;
+      ok &= rte_be_to_cpu_16(uh->payload_len) <= max_payload_;
+    }
+    if (!ok) {
+      rte_pktmbuf_free(m);
+      ev.op = RTE_EVENT_OP_RELEASE;
+      return;
+    }
+    ev.queue_id = STAGE_APP;
+    ev.op = RTE_EVENT_OP_FORWARD;
+  }
+
+  // Application stage: the server's duplex demo, echo the frame back to its
+  // sender — swap the MACs in place and transmit on this worker's own queue
+  void stage_app(struct rte_event &ev, uint16_t tx_queue,
+                 stats::LcoreStats &ls) {
+    struct rte_mbuf *m = ev.mbuf;
+    struct rte_ether_hdr *eth = rte_pktmbuf_mtod(m, struct rte_ether_hdr *);
+    struct rte_ether_addr tmp = eth->dst_addr;
+    eth->dst_addr = eth->src_addr;
+    eth->src_addr = tmp;
+    ls.rx_pkts++;
+    uint16_t sent = 0;
+    while (sent < 1)
+      sent = rte_eth_tx_burst(cfg_.port_id, tx_queue, &m, 1);
+    ls.tx_pkts++;
+    ev.op = RTE_EVENT_OP_RELEASE;
+  }
+
+  static int worker_main(void *arg) {
+    WorkerArg *wa = (WorkerArg *)arg;
+    EventPipeline *pipe = wa->pipe;
+    struct rte_event evs[DEFAULT_BURST_SIZE];
+    stats::LcoreStats &ls = stats::local();
+    IdleBackoff backoff(pipe->cfg_.adaptive_poll);
+    for (;;) {
+      uint16_t n = rte_event_dequeue_burst(pipe->dev_id_, wa->ev_port, evs,
+                                           DEFAULT_BURST_SIZE, 0);
+      if (n == 0) {
+        backoff.poll(false);
+        continue;
+      }
+      for (uint16_t i = 0; i < n; ++i) {
+        if (evs[i].queue_id == STAGE_PARSE)
+          pipe->stage_parse(evs[i]);
+        else
+          pipe->stage_app(evs[i], wa->tx_queue, ls);
+      }
+      // FORWARDs move frames to the next stage, RELEASEs drop the atomic
+      // context so the scheduler can hand the flow to someone else
+      uint16_t sent = 0;
+      while (sent < n)
+        sent += rte_event_enqueue_burst(pipe->dev_id_, wa->ev_port, evs + sent,
+                                        n - sent);
+      backoff.poll(true);
+    }
+    return 0;
+  }
+
+  EndpointConfig cfg_;
+  uint8_t dev_id_{0};
+  uint16_t nb_workers_{1};
+  size_t max_payload_{MAX_PAYLOAD};
+  struct rte_mempool *mbuf_pool_{nullptr};
+  bool has_sched_service_{false};
+  uint32_t sched_service_{0};
+  WorkerArg worker_args_[MAX_WORKERS];
+};
+
+} // namespace urp
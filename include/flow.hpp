@@ -0,0 +1,71 @@
+// flow.hpp - NIC-level steering of the protocol EtherTypes via rte_flow
+#pragma once
+
+#include <cstdio>
+#include <rte_ethdev.h>
+#include <rte_flow.h>
+
+// Steer ingress frames matching ether_type to our RX queue(s) and drop
+// everything else in the NIC, so the endpoints stop software-filtering every
+// broadcast on the fabric. Returns false when the PMD rejects the rules; the
+// caller then falls back to promiscuous mode.
+static inline bool flow_steer_ether_type(uint16_t port_id, uint16_t ether_type,
+                                         uint16_t nb_queues = 1) {
+  struct rte_flow_error flow_err{};
+  struct rte_flow_attr attr{};
+  attr.ingress = 1;
+
+  struct rte_flow_item_eth eth_spec{};
+  struct rte_flow_item_eth eth_mask{};
+  eth_spec.hdr.ether_type = rte_cpu_to_be_16(ether_type);
+  eth_mask.hdr.ether_type = RTE_BE16(0xFFFF);
+
+  struct rte_flow_item pattern[2]{};
+  pattern[0].type = RTE_FLOW_ITEM_TYPE_ETH;
+  pattern[0].spec = &eth_spec;
+  pattern[0].mask = &eth_mask;
+  pattern[1].type = RTE_FLOW_ITEM_TYPE_END;
+
+  // Single queue gets a QUEUE action; multi-queue spreads with RSS
+  uint16_t queues[RTE_MAX_QUEUES_PER_PORT];
+  struct rte_flow_action_queue queue_act{};
+  struct rte_flow_action_rss rss_act{};
+  struct rte_flow_action actions[2]{};
+  if (nb_queues > 1) {
+    for (uint16_t q = 0; q < nb_queues; ++q)
+      queues[q] = q;
+    rss_act.queue_num = nb_queues;
+    rss_act.queue = queues;
+    actions[0].type = RTE_FLOW_ACTION_TYPE_RSS;
+    actions[0].conf = &rss_act;
+  } else {
+    queue_act.index = 0;
+    actions[0].type = RTE_FLOW_ACTION_TYPE_QUEUE;
+    actions[0].conf = &queue_act;
+  }
+  actions[1].type = RTE_FLOW_ACTION_TYPE_END;
+
+  if (rte_flow_validate(port_id, &attr, pattern, actions, &flow_err) != 0)
+    return false;
+  if (!rte_flow_create(port_id, &attr, pattern, actions, &flow_err))
+    return false;
+
+  // Drop all other ingress traffic at lower priority. Best-effort: if the
+  // PMD cannot express it, the steering rule above still stands and the
+  // default path just sees less filtering work.
+  struct rte_flow_attr drop_attr{};
+  drop_attr.ingress = 1;
+  drop_attr.priority = 1;
+  struct rte_flow_item drop_pattern[2]{};
+  drop_pattern[0].type = RTE_FLOW_ITEM_TYPE_ETH;
+  drop_pattern[1].type = RTE_FLOW_ITEM_TYPE_END;
+  struct rte_flow_action drop_actions[2]{};
+  drop_actions[0].type = RTE_FLOW_ACTION_TYPE_DROP;
+  drop_actions[1].type = RTE_FLOW_ACTION_TYPE_END;
+  if (rte_flow_validate(port_id, &drop_attr, drop_pattern, drop_actions,
+                        &flow_err) == 0)
+    rte_flow_create(port_id, &drop_attr, drop_pattern, drop_actions,
+                    &flow_err);
+
+  return true;
+}
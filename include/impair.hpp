@@ -0,0 +1,147 @@
+// impair.hpp - deterministic loss/reorder/duplication injection
+//
+// Real links lose too little to exercise the retransmission machinery, so
+// regressions in loss handling only surface in production. This wraps the
+// rte_eth_tx_burst/rte_eth_rx_burst call sites: egress frames can be
+// dropped, duplicated, or held back a configurable distance, and ingress
+// bursts can be thinned, all driven by a seeded PRNG so a run is exactly
+// reproducible. With a zeroed config every call forwards straight through.
+#pragma once
+
+#include <cstdint>
+#include <rte_ethdev.h>
+#include <rte_mbuf.h>
+
+#include "common.hpp"
+
+struct ImpairConfig {
+  // Per-frame probabilities in [0, 1). Duplication transmits the same mbuf
+  // twice via a refcnt bump, so endpoints disable MBUF_FAST_FREE (which
+  // requires refcnt==1) whenever dup_prob is set.
+  double drop_prob = 0.0;
+  double dup_prob = 0.0;
+  double reorder_prob = 0.0;
+  // A reordered frame is held back until this many later frames have gone
+  // out ahead of it
+  uint32_t reorder_dist = 8;
+  // PRNG seed; the same seed replays the same impairment pattern
+  uint64_t seed = 0x5eed5eed5eed5eedULL;
+};
+
+class Impairment {
+public:
+  Impairment() = default;
+
+  explicit Impairment(const ImpairConfig &cfg) { configure(cfg); }
+
+  void configure(const ImpairConfig &cfg) {
+    cfg_ = cfg;
+    rng_ = cfg.seed ? cfg.seed : 1; // xorshift must not start at 0
+    // Fixed-point thresholds so the hot path compares one u32 per frame
+    drop_thresh_ = (uint32_t)(cfg.drop_prob * 4294967296.0);
+    dup_thresh_ = (uint32_t)(cfg.dup_prob * 4294967296.0);
+    reorder_thresh_ = (uint32_t)(cfg.reorder_prob * 4294967296.0);
+    enabled_ = drop_thresh_ || dup_thresh_ || reorder_thresh_;
+  }
+
+  bool enabled() const { return enabled_; }
+
+  // Egress: apply drop/dup/reorder, then put the survivors on the wire.
+  // Returns n so callers see the frames as consumed — a dropped frame looks
+  // exactly like one the wire lost after a successful TX.
+  uint16_t tx_burst(uint16_t port_id, uint16_t queue_id,
+                    struct rte_mbuf **bufs, uint16_t n) {
+    if (!enabled_)
+      return rte_eth_tx_burst(port_id, queue_id, bufs, n);
+
+    // Worst case: every input duplicated plus the released held frame
+    struct rte_mbuf *out[2 * MAX_BURST + 1];
+    uint16_t nb_out = 0;
+    if (n > MAX_BURST)
+      panic("impairment burst %u exceeds %u", n, (unsigned)MAX_BURST);
+
+    for (uint16_t i = 0; i < n; ++i) {
+      struct rte_mbuf *m = bufs[i];
+
+      // Release a held frame once enough traffic has passed it
+      if (held_ && ++held_age_ > cfg_.reorder_dist) {
+        out[nb_out++] = held_;
+        held_ = nullptr;
+      }
+
+      if (next_u32() < drop_thresh_) {
+        // The frame "made it to the wire" and vanished there
+        rte_pktmbuf_free(m);
+        dropped_++;
+        continue;
+      }
+      if (!held_ && next_u32() < reorder_thresh_) {
+        held_ = m;
+        held_age_ = 0;
+        reordered_++;
+        continue;
+      }
+      if (next_u32() < dup_thresh_) {
+        // Send the same frame twice; the PMD frees per transmission
+        rte_pktmbuf_refcnt_update(m, 1);
+        out[nb_out++] = m;
+        duplicated_++;
+      }
+      out[nb_out++] = m;
+    }
+
+    uint16_t sent = 0;
+    while (sent < nb_out)
+      sent += rte_eth_tx_burst(port_id, queue_id, out + sent, nb_out - sent);
+    return n;
+  }
+
+  // Ingress: receive a burst, then thin it with drop_prob — for impairing a
+  // peer that runs without injection
+  uint16_t rx_burst(uint16_t port_id, uint16_t queue_id,
+                    struct rte_mbuf **bufs, uint16_t n) {
+    uint16_t nb_rx = rte_eth_rx_burst(port_id, queue_id, bufs, n);
+    if (!enabled_ || drop_thresh_ == 0)
+      return nb_rx;
+    uint16_t kept = 0;
+    for (uint16_t i = 0; i < nb_rx; ++i) {
+      if (next_u32() < drop_thresh_) {
+        rte_pktmbuf_free(bufs[i]);
+        dropped_++;
+        continue;
+      }
+      bufs[kept++] = bufs[i];
+    }
+    return kept;
+  }
+
+  uint64_t dropped() const { return dropped_; }
+  uint64_t duplicated() const { return duplicated_; }
+  uint64_t reordered() const { return reordered_; }
+
+private:
+  static constexpr uint16_t MAX_BURST = 256;
+
+  // xorshift64*: one multiply and three shifts per frame, fully determined
+  // by the seed
+  uint32_t next_u32() {
+    uint64_t x = rng_;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    rng_ = x;
+    return (uint32_t)((x * 0x2545F4914F6CDD1DULL) >> 32);
+  }
+
+  ImpairConfig cfg_{};
+  bool enabled_{false};
+  uint64_t rng_{1};
+  uint32_t drop_thresh_{0};
+  uint32_t dup_thresh_{0};
+  uint32_t reorder_thresh_{0};
+  struct rte_mbuf *held_{nullptr};
+  uint32_t held_age_{0};
+  uint64_t dropped_{0};
+  uint64_t duplicated_{0};
+  uint64_t reordered_{0};
+};
@@ -0,0 +1,32 @@
+// numa.hpp - NUMA-aware placement of pools, rings, and worker lcores
+#pragma once
+
+#include <cstdio>
+#include <rte_ethdev.h>
+#include <rte_lcore.h>
+
+// Socket the port's NIC hangs off, for allocating the memory it DMAs into;
+// falls back to the caller's socket when the PMD does not report one (e.g.
+// virtual devices)
+static inline int port_socket_id(uint16_t port_id) {
+  int socket = rte_eth_dev_socket_id(port_id);
+  return socket < 0 ? (int)rte_socket_id() : socket;
+}
+
+// Next worker lcore after prev that sits on the given socket. When the
+// node's cores are exhausted this falls back to the next lcore on any node
+// and warns loudly: a cross-node worker pays interconnect latency on every
+// descriptor and payload touch. Returns RTE_MAX_LCORE when no lcore is left.
+static inline unsigned next_lcore_on_socket(unsigned prev, int socket) {
+  for (unsigned l = rte_get_next_lcore(prev, 1, 0); l < RTE_MAX_LCORE;
+       l = rte_get_next_lcore(l, 1, 0)) {
+    if ((int)rte_lcore_to_socket_id(l) == socket)
+      return l;
+  }
+  unsigned l = rte_get_next_lcore(prev, 1, 0);
+  if (l < RTE_MAX_LCORE)
+    printf("warning: no free lcore on socket %d, using lcore %u on socket %u "
+           "(cross-NUMA)\n",
+           socket, l, rte_lcore_to_socket_id(l));
+  return l;
+}
@@ -11,6 +11,7 @@
 #include <rte_mempool.h>
 #include <rte_ring.h>
 
+#include "common.hpp"
 #include "signaling.hpp"
 
 namespace sigproc {
@@ -20,6 +21,8 @@ static constexpr uint32_t MBUF_CACHE_SIZE = 256;
 static constexpr uint16_t RX_DESC_DEFAULT = 1024;
 static constexpr uint16_t TX_DESC_DEFAULT = 1024;
 static constexpr uint16_t BURST_SIZE = 32;
+// Max unacked signaling frames in flight across all channels
+static constexpr uint16_t MAX_OUTSTANDING = 64;
 // Outbound request from application
 struct SigSend {
   uint16_t channel_id;
@@ -37,6 +40,81 @@ struct SigRecv {
   uint8_t payload[SIG_MAX_PAYLOAD];
 };
 
+// Per-channel sequence state. The old layout was a pair of full
+// uint32_t[65536] arrays — half a megabyte of zeros memset on startup and a
+// cold cache line per channel touch — while deployments run a few hundred
+// active channels. Open-addressing hash sized for that, with a small
+// direct-mapped hot cache in front so repeat channel touches stay in L1.
+struct FlowTable {
+  struct Entry {
+    uint16_t channel_id{0};
+    bool in_use{false};
+    uint32_t next_seq{0};
+    uint32_t expect_seq{0};
+    // Lookup generation of the last touch, for idle-channel eviction
+    uint32_t last_used{0};
+  };
+
+  // Power of two, comfortably above the active channel count; linear
+  // probing needs the headroom
+  static constexpr uint32_t NB_ENTRIES = 1024;
+  static constexpr uint32_t NB_HOT = 16;
+
+  Entry entries[NB_ENTRIES];
+  Entry *hot[NB_HOT] = {};
+  uint32_t tick{0};
+
+  static uint32_t hash(uint16_t channel_id) {
+    uint32_t h = channel_id;
+    h *= 0x9E3779B1u; // Fibonacci hashing spreads adjacent channel ids
+    return h >> 16;
+  }
+
+  // Find or create the entry for a channel (channels start at seq 0, so a
+  // fresh entry behaves exactly like the old zeroed arrays). When every
+  // slot is taken the least-recently-touched channel is recycled: the
+  // table is sized for the active set, and channel_id arrives off the wire,
+  // so a full table must degrade to eviction rather than kill the process
+  Entry *lookup(uint16_t channel_id) {
+    Entry *&cached = hot[channel_id & (NB_HOT - 1)];
+    if (cached && cached->channel_id == channel_id) {
+      cached->last_used = ++tick;
+      return cached;
+    }
+    uint32_t idx = hash(channel_id) & (NB_ENTRIES - 1);
+    Entry *stalest = nullptr;
+    for (uint32_t probe = 0; probe < NB_ENTRIES; ++probe) {
+      Entry &e = entries[idx];
+      if (!e.in_use) {
+        e.in_use = true;
+        e.channel_id = channel_id;
+        e.next_seq = 0;
+        e.expect_seq = 0;
+        e.last_used = ++tick;
+        cached = &e;
+        return &e;
+      }
+      if (e.channel_id == channel_id) {
+        e.last_used = ++tick;
+        cached = &e;
+        return &e;
+      }
+      if (!stalest || (int32_t)(stalest->last_used - e.last_used) > 0)
+        stalest = &e;
+      idx = (idx + 1) & (NB_ENTRIES - 1);
+    }
+    // Recycle the idlest entry in place: the slot stays in_use, so the
+    // probe chains of every other entry are untouched, and stale hot-cache
+    // pointers fail their channel_id compare and fall through here
+    stalest->channel_id = channel_id;
+    stalest->next_seq = 0;
+    stalest->expect_seq = 0;
+    stalest->last_used = ++tick;
+    cached = stalest;
+    return stalest;
+  }
+};
+
 struct EndpointConfig {
   uint16_t port_id;
   // Default peer to send DATA to (ACKs use learned src MAC of inbound frames)
@@ -45,6 +123,9 @@ struct EndpointConfig {
   uint32_t ring_size = 4096;
   // Retransmission timeout in cycles
   uint64_t retransmit_timeout_cycles = 0; // 0 => set to hz/10 at runtime
+  // Back off through pause/short sleeps after sustained empty polls instead
+  // of burning the engine lcore at 100% on an idle link (see backoff.hpp)
+  bool adaptive_poll = false;
 };
 
 class SigEndpoint {
@@ -60,6 +141,23 @@ public:
   rte_ring *inbound_ring() const { return inbound_ring_; }
   rte_ring *outbound_ring() const { return outbound_ring_; }
 
+  // Message allocators backed by per-lcore-cached mempools; application
+  // producers get SigSend records here and consumers return SigRecv records
+  SigSend *send_alloc() {
+    void *obj = nullptr;
+    if (rte_mempool_get(send_pool_, &obj) < 0)
+      return nullptr;
+    return (SigSend *)obj;
+  }
+  void send_free(SigSend *rec) { rte_mempool_put(send_pool_, rec); }
+  SigRecv *recv_alloc() {
+    void *obj = nullptr;
+    if (rte_mempool_get(recv_pool_, &obj) < 0)
+      return nullptr;
+    return (SigRecv *)obj;
+  }
+  void recv_free(SigRecv *rec) { rte_mempool_put(recv_pool_, rec); }
+
   // Stop the engine (best-effort). Not strictly needed for demos.
   void stop();
 
@@ -67,18 +165,23 @@ private:
   struct EngineState {
     SigEndpoint *ep;
     struct rte_mbuf *rx_bufs[BURST_SIZE];
-    uint32_t next_seq[65536];
-    uint32_t expect_seq[65536];
+    FlowTable flows;
     uint64_t timeout_cycles;
     rte_ether_addr learned_peer; // last peer from RX
     bool have_learned_peer{false};
+    // One slot per unacked frame; frames across channels pipeline instead of
+    // serializing behind a single pending message
     struct Pending {
-      bool has_pending{false};
+      bool in_use{false};
       uint16_t channel_id{0};
       uint32_t seq{0};
       uint64_t last_tx_cycles{0};
       SigSend send_copy{};
-    } pending;
+    };
+    Pending slots[MAX_OUTSTANDING];
+    uint16_t nb_outstanding{0};
+    SigSend *tx_recs[BURST_SIZE];
+    struct rte_mbuf *tx_bufs[BURST_SIZE];
   };
   explicit SigEndpoint(const EndpointConfig &cfg);
   ~SigEndpoint();
@@ -98,14 +201,17 @@ private:
 
   bool init_dpdk();
   int run_loop();
-  void tx(EngineState &st);
+  // tx/rx return the number of frames moved so run_loop can drive backoff
+  uint16_t tx(EngineState &st);
   void rx_ack(EngineState &st, SigRecv &rcv);
   void rx_sig(EngineState &st, SigRecv &rcv);
-  void rx(EngineState &st);
+  uint16_t rx(EngineState &st);
 
 private:
   EndpointConfig cfg_;
   struct rte_mempool *mbuf_pool_{nullptr};
+  struct rte_mempool *send_pool_{nullptr};
+  struct rte_mempool *recv_pool_{nullptr};
   rte_ether_addr src_mac_{};
   rte_ether_addr peer_mac_default_{};
 
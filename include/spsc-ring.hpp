@@ -0,0 +1,129 @@
+// Cross-core single-producer/single-consumer variant of Ring: acquire/release
+// atomics, head and tail on separate cache lines, and cached peer indices so
+// the common case touches only one shared line per side.
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <span>
+#include <type_traits>
+
+#include "common.hpp"
+
+template <typename T, std::size_t Capacity> class SpscRing {
+  static_assert((Capacity & (Capacity - 1)) == 0,
+                "Capacity must be a power of two");
+
+public:
+  SpscRing() = default;
+
+  [[nodiscard]] bool empty() const noexcept {
+    return head_.load(std::memory_order_acquire) ==
+           tail_.load(std::memory_order_acquire);
+  }
+  [[nodiscard]] std::size_t size() const noexcept {
+    return tail_.load(std::memory_order_acquire) -
+           head_.load(std::memory_order_acquire);
+  }
+  [[nodiscard]] constexpr std::size_t capacity() const noexcept {
+    return Capacity;
+  }
+
+  // Producer side
+  bool push(const T &item) noexcept(std::is_nothrow_copy_assignable_v<T>) {
+    std::size_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail - cached_head_ == Capacity) {
+      cached_head_ = head_.load(std::memory_order_acquire);
+      if (tail - cached_head_ == Capacity)
+        return false;
+    }
+    buf_[tail & mask_] = item;
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  bool push(T &&item) noexcept(std::is_nothrow_move_assignable_v<T>) {
+    std::size_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail - cached_head_ == Capacity) {
+      cached_head_ = head_.load(std::memory_order_acquire);
+      if (tail - cached_head_ == Capacity)
+        return false;
+    }
+    buf_[tail & mask_] = std::move(item);
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer side
+  bool pop(T &item) noexcept(std::is_nothrow_move_constructible_v<T>) {
+    std::size_t head = head_.load(std::memory_order_relaxed);
+    if (head == cached_tail_) {
+      cached_tail_ = tail_.load(std::memory_order_acquire);
+      if (head == cached_tail_)
+        return false;
+    }
+    item = std::move(buf_[head & mask_]);
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  [[nodiscard]] T *peek() noexcept {
+    std::size_t head = head_.load(std::memory_order_relaxed);
+    if (head == cached_tail_) {
+      cached_tail_ = tail_.load(std::memory_order_acquire);
+      if (head == cached_tail_)
+        return nullptr;
+    }
+    return &buf_[head & mask_];
+  }
+
+  // Bulk views over the stored run, consumer side: the span covers entries
+  // the producer has published (acquire on tail), and stays valid until the
+  // consumer pops past it
+  [[nodiscard]] std::span<T> longest_span() noexcept {
+    std::size_t head = head_.load(std::memory_order_relaxed);
+    std::size_t tail = tail_.load(std::memory_order_acquire);
+    return std::span<T>(&buf_[head & mask_],
+                        std::min(tail - head, Capacity - (head & mask_)));
+  }
+
+  [[nodiscard]] std::span<T> span_from(std::size_t start) noexcept {
+    std::size_t head = head_.load(std::memory_order_relaxed);
+    std::size_t tail = tail_.load(std::memory_order_acquire);
+
+    if (start < head) {
+      panic("start < head: %zu < %zu", start, head);
+    }
+
+    if (start > tail) {
+      panic("start > tail: %zu > %zu", start, tail);
+    }
+
+    return std::span<T>(&buf_[start & mask_],
+                        std::min(tail - start, Capacity - (start & mask_)));
+  }
+
+  [[nodiscard]] T &operator[](std::size_t index) noexcept {
+    return buf_[(head_.load(std::memory_order_relaxed) + index) & mask_];
+  }
+
+  [[nodiscard]] std::size_t head() const noexcept {
+    return head_.load(std::memory_order_acquire);
+  }
+  [[nodiscard]] std::size_t tail() const noexcept {
+    return tail_.load(std::memory_order_acquire);
+  }
+
+private:
+  static constexpr std::size_t mask_ = Capacity - 1;
+
+  // Consumer line: head plus the consumer's cached copy of tail
+  alignas(64) std::atomic<std::size_t> head_{0};
+  std::size_t cached_tail_ = 0;
+  // Producer line: tail plus the producer's cached copy of head
+  alignas(64) std::atomic<std::size_t> tail_{0};
+  std::size_t cached_head_ = 0;
+
+  alignas(64) std::array<T, Capacity> buf_{};
+};
@@ -6,19 +6,29 @@
 #include <rte_ethdev.h>
 #include <rte_ether.h>
 #include <rte_malloc.h>
+#include <rte_mbuf.h>
 #include <rte_mbuf_core.h>
 #include <rte_mempool.h>
+#include <rte_prefetch.h>
 #include <rte_ring.h>
 #include <rte_ring_core.h>
 #include <span>
+#include <stddef.h>
 #include <stdint.h>
+#include <vector>
 
 #include "common.hpp"
+#include "flow.hpp"
+#include "impair.hpp"
+#include "numa.hpp"
 #include "ring.hpp"
 
 namespace srp {
 
 static constexpr size_t BURST_SIZE = 64;
+// Upper bound on the send window (outstanding unacked frames); the actual
+// window is EndpointConfig::send_window
+static constexpr size_t MAX_WINDOW = 4096;
 static constexpr size_t RX_DESC_DEFAULT = 128;
 static constexpr size_t TX_DESC_DEFAULT = 128;
 
@@ -43,7 +53,19 @@ struct srp_hdr {
   uint8_t payload[MAX_PAYLOAD];
 };
 
-static inline int port_init(uint16_t port_id, struct rte_mempool *pool) {
+// Parsed view of a received frame: header fields in host order plus a
+// pointer into the mbuf payload. Replaces the old by-value srp_hdr return,
+// which copied 1036 bytes onto the stack per packet.
+struct FrameView {
+  bool ok;
+  uint16_t opcode;
+  uint16_t payload_len;
+  uint32_t seq;
+  const uint8_t *payload;
+};
+
+static inline int port_init(uint16_t port_id, struct rte_mempool *pool,
+                            bool flow_steering = true) {
   struct rte_eth_conf port_conf{};
   port_conf.rxmode.mq_mode = RTE_ETH_MQ_RX_NONE;
   port_conf.txmode.mq_mode = RTE_ETH_MQ_TX_NONE;
@@ -62,18 +84,40 @@ static inline int port_init(uint16_t port_id, struct rte_mempool *pool) {
   ret = rte_eth_dev_start(port_id);
   if (ret < 0)
     panic("Failed to start port %u", port_id);
-  rte_eth_promiscuous_enable(port_id);
+  // Steer our EtherType in the NIC; promiscuous mode is only the fallback
+  // for PMDs without rte_flow support
+  if (!flow_steering || !flow_steer_ether_type(port_id, ETH_TYPE)) {
+    if (flow_steering)
+      printf("port %u: rte_flow steering unavailable, "
+             "falling back to promiscuous mode\n",
+             port_id);
+    rte_eth_promiscuous_enable(port_id);
+  }
   return port_id;
 }
 
 struct EndpointConfig {
   uint16_t port_id;
+  // Link aggregation: all member ports to the same peer. Empty means just
+  // port_id; otherwise port_id should be the first entry (it names the
+  // shared resources and provides the source MAC). DATA bursts rotate
+  // across members, RX polls them all, and the window/reorder/SACK
+  // machinery runs over the one aggregate sequence space.
+  std::vector<uint16_t> ports;
   // Default peer to send DATA to (ACKs use learned src MAC of inbound frames)
   rte_ether_addr default_peer_mac;
   // Queue sizes
   uint32_t ring_size = 4096;
   // Retransmission timeout in cycles
   uint64_t retransmit_timeout_cycles = 0; // 0 => set to hz/10 at runtime
+  // Send window: max unacked frames in flight (capped at MAX_WINDOW)
+  uint32_t send_window = 1024;
+  // Steer our EtherType to the RX queue via rte_flow instead of running the
+  // port promiscuous (automatic fallback when the PMD lacks support)
+  bool flow_steering = true;
+  // Loss/reorder/duplication injection for protocol benchmarking; zeroed
+  // probabilities leave the data path untouched (see impair.hpp)
+  ImpairConfig impair;
 };
 
 class SRPEndpoint {
@@ -84,37 +128,87 @@ public:
     st.timeout_cycles = cfg.retransmit_timeout_cycles;
     if (st.timeout_cycles == 0)
       st.timeout_cycles = rte_get_timer_hz() / 10;
+    st.window = cfg.send_window;
+    if (st.window > MAX_WINDOW)
+      st.window = MAX_WINDOW;
     st.learned_peer = cfg.default_peer_mac;
     st.have_learned_peer = false;
+    impair_.configure(cfg.impair);
   }
 
   explicit SRPEndpoint(const EndpointConfig &cfg) {
-    mbuf_pool_ = rte_pktmbuf_pool_create("MBUF_POOL", 1024, 128, 0, 2048,
-                                         rte_socket_id());
+    ports_ = cfg.ports.empty() ? std::vector<uint16_t>{cfg.port_id}
+                               : cfg.ports;
+    // Place everything the NIC DMAs into — and the rings the engine polls —
+    // on the NIC's node, not the node of whichever core runs the ctor.
+    // Aggregated ports are expected to sit on the same node; the first
+    // member decides.
+    int socket = port_socket_id(ports_[0]);
+    // All resource names carry the port id so several endpoints can share
+    // one process (and one EAL hugepage reservation)
+    char mbuf_pool_name[64];
+    snprintf(mbuf_pool_name, sizeof(mbuf_pool_name), "srp_mbuf_%u",
+             cfg.port_id);
+    // The pool backs the full send window plus every member port's RX
+    // descriptors, in-flight ACK frames, and the per-lcore cache; sizing it
+    // below that panics tx() on a perfectly healthy link once in-flight
+    // frames approach the pool size
+    uint32_t window = cfg.send_window > MAX_WINDOW ? (uint32_t)MAX_WINDOW
+                                                   : cfg.send_window;
+    uint32_t nb_mbufs = window +
+                        (uint32_t)(ports_.size() *
+                                   (RX_DESC_DEFAULT + TX_DESC_DEFAULT)) +
+                        (uint32_t)BURST_SIZE + 2 * 128;
+    mbuf_pool_ = rte_pktmbuf_pool_create(
+        mbuf_pool_name, rte_align32pow2(nb_mbufs) - 1, 128, 0, 2048, socket);
     cfg_ = cfg;
 
+    // Payload objects come from a per-lcore-cached mempool instead of the
+    // rte_malloc heap, whose lock is hot at high message rates
+    char pool_name[64];
+    snprintf(pool_name, sizeof(pool_name), "srp_payload_%u", cfg.port_id);
+    payload_pool_ = rte_mempool_create(pool_name, 8192 - 1, sizeof(Payload),
+                                       256, 0, NULL, NULL, NULL, NULL, socket,
+                                       0);
+    if (!payload_pool_)
+      panic("Failed to create SRP payload pool: %s", rte_strerror(rte_errno));
+
     struct rte_mbuf *m = rte_pktmbuf_alloc(mbuf_pool_);
 
-    printf("port id: %u\n", cfg.port_id);
-    port_init(cfg.port_id, mbuf_pool_);
+    for (uint16_t port : ports_) {
+      printf("port id: %u\n", port);
+      port_init(port, mbuf_pool_, cfg.flow_steering);
+    }
 
-    rte_eth_macaddr_get(cfg.port_id, &src_mac_);
+    // One identity for the aggregate: all frames carry the first member's
+    // MAC, so the peer learns a single return address
+    rte_eth_macaddr_get(ports_[0], &src_mac_);
+
+    // Pre-build the ether+srp header image once; fill_data_frame copies it
+    // into each frame and patches only dst/seq/payload_len
+    struct rte_ether_hdr *teth = (struct rte_ether_hdr *)tx_hdr_template_;
+    rte_ether_addr_copy(&cfg.default_peer_mac, &teth->dst_addr);
+    rte_ether_addr_copy(&src_mac_, &teth->src_addr);
+    teth->ether_type = rte_cpu_to_be_16(ETH_TYPE);
+    srp_hdr *tsh = (srp_hdr *)(teth + 1);
+    tsh->version = rte_cpu_to_be_16(1);
+    tsh->opcode = rte_cpu_to_be_16(OPCODE_DATA);
+    tsh->seq = 0;
+    tsh->payload_len = 0;
 
     char in_name[64];
     char out_name[64];
-    snprintf(in_name, sizeof(in_name), "sig_in_%u", cfg_.port_id);
-    snprintf(out_name, sizeof(out_name), "sig_out_%u", cfg_.port_id);
+    snprintf(in_name, sizeof(in_name), "srp_in_%u", cfg_.port_id);
+    snprintf(out_name, sizeof(out_name), "srp_out_%u", cfg_.port_id);
 
-    inbound_ring_ =
-        rte_ring_create("inbound_ring", cfg.ring_size, rte_socket_id(),
-                        RING_F_SC_DEQ | RING_F_SP_ENQ);
+    inbound_ring_ = rte_ring_create(in_name, cfg.ring_size, socket,
+                                    RING_F_SC_DEQ | RING_F_SP_ENQ);
 
     if (!inbound_ring_) {
       panic("Failed to create inbound ring");
     }
-    outbound_ring_ =
-        rte_ring_create("outbound_ring", cfg.ring_size, rte_socket_id(),
-                        RING_F_SP_ENQ | RING_F_SC_DEQ);
+    outbound_ring_ = rte_ring_create(out_name, cfg.ring_size, socket,
+                                     RING_F_SP_ENQ | RING_F_SC_DEQ);
 
     if (!outbound_ring_) {
       panic("Failed to create outbound ring");
@@ -131,6 +225,16 @@ public:
   rte_ring *inbound_ring() const { return inbound_ring_; }
   rte_ring *outbound_ring() const { return outbound_ring_; }
 
+  // Payload allocator for application producers/consumers; backed by the
+  // per-lcore-cached payload mempool
+  Payload *payload_alloc() {
+    void *obj = nullptr;
+    if (rte_mempool_get(payload_pool_, &obj) < 0)
+      return nullptr;
+    return (Payload *)obj;
+  }
+  void payload_free(Payload *p) { rte_mempool_put(payload_pool_, p); }
+
   void progress() {
     tx(st);
     rx(st);
@@ -143,11 +247,29 @@ private:
   struct EngineState {
     SRPEndpoint *ep;
     struct rte_mbuf *rx_bufs[BURST_SIZE];
-    Ring<rte_mbuf *, BURST_SIZE> outstanding_tx;
+    Payload *tx_payloads[BURST_SIZE];
+    Payload *rx_payload_cache[BURST_SIZE];
+    struct rte_mbuf *alloc_bufs[BURST_SIZE];
+    struct rte_mbuf *free_bufs[BURST_SIZE];
+    Ring<rte_mbuf *, MAX_WINDOW> outstanding_tx;
+    uint32_t window{MAX_WINDOW};
     uint32_t tx_seq{0};
+    uint32_t tx_acked{0}; // cumulative: all seqs below this are acked
     uint32_t rx_seq{0};
     bool need_ack{false};
-    uint64_t last_tx_cycles{0};
+    // Receive-side reorder buffer: slot seq & (MAX_WINDOW - 1) holds the
+    // payload of an out-of-order frame until the gap before it is filled
+    Payload *reorder_buf[MAX_WINDOW] = {};
+    Payload *deliver_buf[BURST_SIZE];
+    struct rte_mbuf *retx_bufs[BURST_SIZE];
+    // Last SACK info from the peer: bit b of sack_bitmap set means seq
+    // sack_base + b has been received out of order
+    uint32_t sack_base{0};
+    uint64_t sack_bitmap{0};
+    // Per-frame transmit timestamps, slot seq & (MAX_WINDOW - 1); each
+    // outstanding frame times out on its own clock instead of one shared
+    // timer re-sending the whole span
+    uint64_t tx_cycles[MAX_WINDOW] = {};
     uint64_t timeout_cycles{0};
     rte_ether_addr learned_peer; // last peer from RX
     bool have_learned_peer{false};
@@ -155,70 +277,76 @@ private:
 
   EngineState st;
 
-  struct rte_mbuf *build_data_frame(struct rte_mempool *pool,
-                                    const rte_ether_addr *src_mac,
-                                    const rte_ether_addr *dst_mac,
-                                    Payload *payload, uint32_t seq) {
+  // Write the header-template image into a pre-allocated mbuf, patch the
+  // per-frame fields, and copy the payload
+  void fill_data_frame(struct rte_mbuf *m, Payload *payload, uint32_t seq) {
     size_t frame_len = sizeof(struct rte_ether_hdr) + sizeof(srp_hdr);
-    struct rte_mbuf *m = rte_pktmbuf_alloc(pool);
-    if (!m)
-      panic("Failed to allocate mbuf");
     uint8_t *data = rte_pktmbuf_mtod(m, uint8_t *);
     rte_pktmbuf_reset_headroom(m);
-    if (rte_pktmbuf_append(m, frame_len) == NULL) {
-      rte_pktmbuf_free(m);
+    if (rte_pktmbuf_append(m, frame_len) == NULL)
       panic("Failed to append mbuf");
-    }
-    struct rte_ether_hdr *eth = (struct rte_ether_hdr *)data;
-    rte_ether_addr_copy(dst_mac, &eth->dst_addr);
-    rte_ether_addr_copy(src_mac, &eth->src_addr);
-    eth->ether_type = rte_cpu_to_be_16(ETH_TYPE);
-    srp_hdr *sh = (srp_hdr *)(eth + 1);
-    sh->version = rte_cpu_to_be_16(1);
-    sh->opcode = rte_cpu_to_be_16(OPCODE_DATA);
+    rte_memcpy(data, tx_hdr_template_, sizeof(tx_hdr_template_));
+    srp_hdr *sh = (srp_hdr *)((struct rte_ether_hdr *)data + 1);
     sh->seq = rte_cpu_to_be_32(seq);
     sh->payload_len = rte_cpu_to_be_16(payload->size);
     if (payload->size) {
       rte_memcpy(sh->payload, payload->data, payload->size);
     }
-    return m;
   }
 
-  srp_hdr parse_frame(struct rte_mbuf *m) {
-    srp_hdr sh;
-
+  // Validate and decode a frame in place: the fields come back in host order
+  // and payload points into the mbuf, so the hot loop never copies a header
+  FrameView parse_frame(struct rte_mbuf *m) {
+    FrameView v{};
     if (rte_pktmbuf_pkt_len(m) < sizeof(struct rte_ether_hdr) + sizeof(srp_hdr))
-      return sh;
+      return v;
+
     struct rte_ether_hdr *eth = rte_pktmbuf_mtod(m, struct rte_ether_hdr *);
-    if (eth->ether_type != rte_cpu_to_be_16(ETH_TYPE))
-      return sh;
-    sh = *(srp_hdr *)(eth + 1);
-    uint16_t version = rte_be_to_cpu_16(sh.version);
-    if (version != 1)
-      panic("unsupported version %u", version);
-    sh.opcode = rte_be_to_cpu_16(sh.opcode);
-    sh.payload_len = rte_be_to_cpu_16(sh.payload_len);
-    sh.seq = rte_be_to_cpu_32(sh.seq);
-    size_t need = sizeof(struct rte_ether_hdr) + sizeof(srp_hdr);
-    if (rte_pktmbuf_pkt_len(m) < need || sh.payload_len > 1024)
-      panic("invalid frame");
-    if (sh.payload_len) {
-      // rte_memcpy(sh.payload, sh.payload, sh.payload_len);
-    }
-    return sh;
+    srp_hdr *sh = (srp_hdr *)(eth + 1);
+
+    // Fold the validity compares into one flag instead of a branch per field
+    bool ok = eth->ether_type == rte_cpu_to_be_16(ETH_TYPE);
+    ok &= rte_be_to_cpu_16(sh->version) == 1;
+    v.payload_len = rte_be_to_cpu_16(sh->payload_len);
+    ok &= v.payload_len <= MAX_PAYLOAD;
+    v.ok = ok;
+
+    v.opcode = rte_be_to_cpu_16(sh->opcode);
+    v.seq = rte_be_to_cpu_32(sh->seq);
+    v.payload = sh->payload;
+    return v;
+  }
+
+  // True if the peer reported seq as received in its last SACK bitmap
+  bool sacked(EngineState &st, uint32_t seq) const {
+    if (st.sack_base != st.tx_acked)
+      return false; // bitmap is stale relative to the cumulative ACK
+    uint32_t off = seq - st.sack_base;
+    return off < 64 && (st.sack_bitmap >> off) & 1;
   }
 
   void tx_retransmit(EngineState &st) {
     if (st.outstanding_tx.empty())
       return;
 
-    // retransmit on timeout
+    // Selective retransmission: re-send only frames whose own timer has
+    // expired and that the peer has not SACKed, so one late ACK or one lost
+    // frame no longer re-sends the window
     uint64_t now = rte_get_timer_cycles();
-    if (now - st.last_tx_cycles >= st.timeout_cycles) {
-
-      auto span = st.outstanding_tx.longest_span();
-      uint16_t s = rte_eth_tx_burst(cfg_.port_id, 0, span.data(), span.size());
-      st.last_tx_cycles = now;
+    uint16_t nb_retx = 0;
+    uint32_t n = st.outstanding_tx.size();
+    for (uint32_t i = 0; i < n && nb_retx < BURST_SIZE; ++i) {
+      uint32_t seq = st.tx_acked + i;
+      if (sacked(st, seq))
+        continue; // receiver already holds it
+      uint64_t &stamp = st.tx_cycles[seq & (MAX_WINDOW - 1)];
+      if (now - stamp < st.timeout_cycles)
+        continue;
+      st.retx_bufs[nb_retx++] = st.outstanding_tx[i];
+      stamp = now; // restart this frame's timer
+    }
+    if (nb_retx > 0) {
+      uint16_t s = impair_.tx_burst(next_tx_port(), 0, st.retx_bufs, nb_retx);
     }
   }
 
@@ -226,41 +354,58 @@ private:
     // retransmit on timeout
     tx_retransmit(st);
 
-    // TX: if nothing pending, pull from outbound ring and send; else
-    // retransmit on timeout
-    Payload *payload;
+    // TX: pull as much from the outbound ring as the send window allows and
+    // pipeline it; ACKs open the window back up in rx_ack
     auto tx_start = st.outstanding_tx.tail();
-    if (rte_ring_sc_dequeue(outbound_ring_, (void **)&payload) == 0) {
-      uint32_t seq = st.tx_seq++;
-      const rte_ether_addr *dst =
-          st.have_learned_peer ? &st.learned_peer : &cfg_.default_peer_mac;
-      // printf("build_data_frame: dst %p mpool %p\n", dst, mbuf_pool_);
-      struct rte_mbuf *m =
-          build_data_frame(mbuf_pool_, &src_mac_, dst, payload, seq);
-      if (m) {
-        st.outstanding_tx.push(m);
-      } else {
-        panic("Failed to build data frame");
+    uint32_t in_flight = st.outstanding_tx.size();
+    uint32_t space = st.window > in_flight ? st.window - in_flight : 0;
+    if (space > BURST_SIZE)
+      space = BURST_SIZE;
+
+    uint32_t nb = 0;
+    if (space > 0 &&
+        (nb = rte_ring_sc_dequeue_burst(outbound_ring_,
+                                        (void **)st.tx_payloads, space,
+                                        nullptr)) != 0) {
+      // Patch the header template's dst once per burst and take one mempool
+      // round trip for all the mbufs
+      struct rte_ether_hdr *teth = (struct rte_ether_hdr *)tx_hdr_template_;
+      rte_ether_addr_copy(st.have_learned_peer ? &st.learned_peer
+                                               : &cfg_.default_peer_mac,
+                          &teth->dst_addr);
+      if (rte_pktmbuf_alloc_bulk(mbuf_pool_, st.alloc_bufs, nb) != 0)
+        panic("Failed to bulk-allocate TX mbufs");
+      uint64_t now = rte_get_timer_cycles();
+      for (uint32_t i = 0; i < nb; ++i) {
+        if (i + 1 < nb)
+          rte_prefetch0(rte_pktmbuf_mtod(st.alloc_bufs[i + 1], void *));
+        st.tx_cycles[st.tx_seq & (MAX_WINDOW - 1)] = now;
+        fill_data_frame(st.alloc_bufs[i], st.tx_payloads[i], st.tx_seq++);
+        st.outstanding_tx.push(st.alloc_bufs[i]);
+        payload_free(st.tx_payloads[i]);
       }
-      rte_free(payload);
-    } else {
+    } else if (nb == 0) {
       rte_pause();
     }
 
+    // Whole bursts rotate across the member ports (not single frames), so
+    // each port still sees full-burst TX calls; the shared sequence space
+    // and the reorder buffer absorb the cross-port skew
     auto tx_span = st.outstanding_tx.span_from(tx_start);
     if (tx_span.size() > 0) {
-      uint16_t s =
-          rte_eth_tx_burst(cfg_.port_id, 0, tx_span.data(), tx_span.size());
+      uint16_t port = next_tx_port();
+      uint16_t s = impair_.tx_burst(port, 0, tx_span.data(), tx_span.size());
       tx_span = st.outstanding_tx.span_from(tx_start + tx_span.size());
       if (tx_span.size() > 0) {
-        s = rte_eth_tx_burst(cfg_.port_id, 0, tx_span.data(), tx_span.size());
+        s = impair_.tx_burst(port, 0, tx_span.data(), tx_span.size());
       }
     }
   }
 
   struct rte_mbuf *build_ack_frame(struct rte_mempool *pool,
                                    const rte_ether_addr *src,
-                                   const rte_ether_addr *dst, uint32_t seq) {
+                                   const rte_ether_addr *dst, uint32_t seq,
+                                   uint64_t sack_bitmap) {
     size_t frame_len = sizeof(struct rte_ether_hdr) + sizeof(srp_hdr);
     struct rte_mbuf *m = rte_pktmbuf_alloc(pool);
     if (!m)
@@ -279,34 +424,74 @@ private:
     sh->version = rte_cpu_to_be_16(1);
     sh->seq = rte_cpu_to_be_32(seq);
     sh->opcode = rte_cpu_to_be_16(OPCODE_ACK);
-    sh->payload_len = rte_cpu_to_be_16(0);
+    sh->payload_len = rte_cpu_to_be_16(sizeof(uint64_t));
+    uint64_t be_bitmap = rte_cpu_to_be_64(sack_bitmap);
+    rte_memcpy(sh->payload, &be_bitmap, sizeof(be_bitmap));
     return m;
   }
 
-  void rx_ack(EngineState &st, srp_hdr &rcv) {
-    // receive ack, update the head of outstanding_tx
+  void rx_ack(EngineState &st, const FrameView &rcv) {
+    // Cumulative ACK: everything below rcv.seq is received; drop the acked
+    // prefix of outstanding_tx and free the mbufs in bulk
+    if (rcv.payload_len >= sizeof(uint64_t)) {
+      uint64_t be_bitmap;
+      rte_memcpy(&be_bitmap, rcv.payload, sizeof(be_bitmap));
+      st.sack_base = rcv.seq;
+      st.sack_bitmap = rte_be_to_cpu_64(be_bitmap);
+    }
 
-    auto acked = rcv.seq - st.rx_seq;
-    for (int i = 0; i < acked; i++) {
-      struct rte_mbuf *m;
-      if (st.outstanding_tx.pop(m)) {
-        rte_pktmbuf_free(m);
-        break;
-      } else {
-        panic("outstanding_tx is empty");
+    uint32_t acked = rcv.seq - st.tx_acked;
+    if (acked == 0 || acked > st.outstanding_tx.size())
+      return; // stale or bogus ACK
+    st.tx_acked = rcv.seq;
+
+    while (acked > 0) {
+      uint32_t chunk = acked < BURST_SIZE ? acked : (uint32_t)BURST_SIZE;
+      for (uint32_t i = 0; i < chunk; ++i) {
+        if (!st.outstanding_tx.pop(st.free_bufs[i]))
+          panic("outstanding_tx is empty");
       }
+      rte_pktmbuf_free_bulk(st.free_bufs, chunk);
+      acked -= chunk;
     }
   }
 
+  // Poll every member port; deliveries land on the one inbound ring and the
+  // window/ACK state is shared, so the aggregate behaves as a single link
   void rx(EngineState &st) {
+    for (uint16_t port : ports_)
+      rx_port(st, port);
+  }
+
+  void rx_port(EngineState &st, uint16_t port) {
     // RX first: handle ACKs and inbound DATA; send ACKs for DATA
-    uint16_t nb_rx = rte_eth_rx_burst(cfg_.port_id, 0, st.rx_bufs, BURST_SIZE);
+    uint16_t nb_rx = impair_.rx_burst(port, 0, st.rx_bufs, BURST_SIZE);
+    if (nb_rx == 0)
+      return;
+
+    // Bulk-get enough payloads for the whole burst; leftovers go back in one
+    // bulk put below
+    uint16_t nb_payloads = nb_rx;
+    if (rte_mempool_get_bulk(payload_pool_, (void **)st.rx_payload_cache,
+                             nb_payloads) < 0)
+      nb_payloads = 0; // degrade: drop deliveries this burst
+    uint16_t payloads_used = 0;
+
+    // Vector-PMD-style parse pipeline: packet data is prefetched two
+    // iterations before it is parsed, so the header loads below hit L1
+    for (uint16_t i = 0; i < nb_rx && i < 2; ++i)
+      rte_prefetch0(rte_pktmbuf_mtod(st.rx_bufs[i], void *));
+
     for (uint16_t i = 0; i < nb_rx; ++i) {
+      if (i + 2 < nb_rx)
+        rte_prefetch0(rte_pktmbuf_mtod(st.rx_bufs[i + 2], void *));
       struct rte_mbuf *m = st.rx_bufs[i];
-      srp_hdr rcv = parse_frame(m);
+      FrameView rcv = parse_frame(m);
+      if (!rcv.ok) {
+        rte_pktmbuf_free(m);
+        continue;
+      }
 
-      // printf("RX: seq=%u, opcode=%u, payload_len=%u\n", rcv.seq, rcv.opcode,
-      //        rcv.payload_len);
       // learn peer MAC from frame src
       struct rte_ether_hdr *eth = rte_pktmbuf_mtod(m, struct rte_ether_hdr *);
       rte_ether_addr_copy(&eth->src_addr, &st.learned_peer);
@@ -315,19 +500,16 @@ private:
       if (rcv.opcode == OPCODE_ACK) {
         rx_ack(st, rcv);
       } else {
-        // Enqueue inbound DATA only if in-order
-        uint32_t rx_seq = st.rx_seq;
-        if (rcv.seq == rx_seq) {
-          st.rx_seq = rx_seq + 1;
-          // Copy and deliver
-
-          auto payload = (Payload *)rte_zmalloc(NULL, sizeof(Payload),
-                                                RTE_CACHE_LINE_SIZE);
-          if (payload) {
+        // Park inbound DATA in the reorder buffer; anything outside the
+        // window (old duplicate or too far ahead) is dropped
+        uint32_t offset = rcv.seq - st.rx_seq;
+        if (offset < st.window) {
+          uint32_t slot = rcv.seq & (MAX_WINDOW - 1);
+          if (!st.reorder_buf[slot] && payloads_used < nb_payloads) {
+            Payload *payload = st.rx_payload_cache[payloads_used++];
             payload->size = rcv.payload_len;
             rte_memcpy(payload->data, rcv.payload, payload->size);
-            while (rte_ring_sp_enqueue(inbound_ring_, payload) == -ENOBUFS) {
-            }
+            st.reorder_buf[slot] = payload;
           }
         }
 
@@ -336,29 +518,77 @@ private:
 
       rte_pktmbuf_free(m);
     }
+
+    // Deliver the contiguous run starting at rx_seq in bulk
+    while (st.reorder_buf[st.rx_seq & (MAX_WINDOW - 1)]) {
+      uint32_t run = 0;
+      while (run < BURST_SIZE &&
+             st.reorder_buf[st.rx_seq & (MAX_WINDOW - 1)]) {
+        uint32_t slot = st.rx_seq & (MAX_WINDOW - 1);
+        st.deliver_buf[run++] = st.reorder_buf[slot];
+        st.reorder_buf[slot] = nullptr;
+        st.rx_seq++;
+      }
+      uint32_t enq = 0;
+      while (enq < run) {
+        enq += rte_ring_sp_enqueue_burst(
+            inbound_ring_, (void **)(st.deliver_buf + enq), run - enq, nullptr);
+      }
+    }
+
     if (st.need_ack) {
-      // send the latest seq number as ACK
+      // Cumulative ACK for rx_seq plus a bitmap of the 64 seqs after it so
+      // the sender can retransmit only what is actually missing
+      uint64_t bitmap = 0;
+      for (uint32_t b = 1; b < 64; ++b) {
+        if (st.reorder_buf[(st.rx_seq + b) & (MAX_WINDOW - 1)])
+          bitmap |= (uint64_t)1 << b;
+      }
       const rte_ether_addr *dst =
           st.have_learned_peer ? &st.learned_peer : &peer_mac_default_;
       struct rte_mbuf *ack =
-          build_ack_frame(mbuf_pool_, &src_mac_, dst, st.rx_seq);
+          build_ack_frame(mbuf_pool_, &src_mac_, dst, st.rx_seq, bitmap);
       if (ack) {
-        uint16_t s = rte_eth_tx_burst(cfg_.port_id, 0, &ack, 1);
+        // ACK goes back out the port the data arrived on
+        uint16_t s = impair_.tx_burst(port, 0, &ack, 1);
         if (s == 0)
           rte_pktmbuf_free(ack);
       }
       st.need_ack = false;
     }
+
+    if (payloads_used < nb_payloads)
+      rte_mempool_put_bulk(payload_pool_,
+                           (void **)(st.rx_payload_cache + payloads_used),
+                           nb_payloads - payloads_used);
+  }
+
+  // Next member port for a TX burst; the engine is single-threaded, so a
+  // plain counter does
+  uint16_t next_tx_port() {
+    uint16_t port = ports_[tx_port_rr_];
+    if (++tx_port_rr_ == ports_.size())
+      tx_port_rr_ = 0;
+    return port;
   }
 
   rte_ring *inbound_ring_{nullptr};
   rte_ring *outbound_ring_{nullptr};
 
   EndpointConfig cfg_;
+  // Member ports of the aggregate (just cfg_.port_id when not aggregating)
+  std::vector<uint16_t> ports_;
+  uint16_t tx_port_rr_{0};
+  Impairment impair_;
   struct rte_mempool *mbuf_pool_{nullptr};
+  struct rte_mempool *payload_pool_{nullptr};
   rte_ether_addr src_mac_{};
   rte_ether_addr peer_mac_default_{};
 
+  // Pre-built ether+srp header image (headers only, not the payload array)
+  uint8_t tx_hdr_template_[sizeof(struct rte_ether_hdr) +
+                           offsetof(srp_hdr, payload)]{};
+
   ~SRPEndpoint();
 };
 
@@ -0,0 +1,173 @@
+// stats.hpp - per-lcore counters and latency histograms, aggregated and
+// reported off the hot path by a dedicated reporter thread
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <rte_cycles.h>
+#include <rte_lcore.h>
+#include <thread>
+
+namespace stats {
+
+// HDR-style log-bucketed histogram: one power-of-two range split into
+// 2^SUB_BITS linear sub-buckets, so relative error stays bounded while the
+// hot-path record() is two shifts and an increment.
+struct Histogram {
+  static constexpr uint32_t SUB_BITS = 3;
+  static constexpr uint32_t SUB_COUNT = 1u << SUB_BITS;
+  static constexpr uint32_t NB_BUCKETS = (64 - SUB_BITS) * SUB_COUNT;
+
+  uint64_t buckets[NB_BUCKETS] = {};
+
+  static uint32_t bucket_index(uint64_t v) {
+    if (v < SUB_COUNT)
+      return (uint32_t)v;
+    uint32_t msb = 63 - __builtin_clzll(v);
+    return ((msb - SUB_BITS + 1) << SUB_BITS) +
+           (uint32_t)((v >> (msb - SUB_BITS)) & (SUB_COUNT - 1));
+  }
+
+  static uint64_t bucket_floor(uint32_t idx) {
+    uint32_t exp = idx >> SUB_BITS;
+    uint64_t sub = idx & (SUB_COUNT - 1);
+    if (exp == 0)
+      return sub;
+    return ((uint64_t)SUB_COUNT + sub) << (exp - 1);
+  }
+
+  void record(uint64_t v) { buckets[bucket_index(v)]++; }
+
+  uint64_t total() const {
+    uint64_t t = 0;
+    for (uint32_t i = 0; i < NB_BUCKETS; ++i)
+      t += buckets[i];
+    return t;
+  }
+
+  // Lower bound of the bucket containing the p-quantile (0 < p <= 1)
+  uint64_t percentile(double p) const {
+    uint64_t t = total();
+    if (t == 0)
+      return 0;
+    uint64_t rank = (uint64_t)(p * (double)t);
+    uint64_t seen = 0;
+    for (uint32_t i = 0; i < NB_BUCKETS; ++i) {
+      seen += buckets[i];
+      if (seen >= rank)
+        return bucket_floor(i);
+    }
+    return bucket_floor(NB_BUCKETS - 1);
+  }
+
+  void merge(const Histogram &o) {
+    for (uint32_t i = 0; i < NB_BUCKETS; ++i)
+      buckets[i] += o.buckets[i];
+  }
+};
+
+// One cache-line-padded counter block per lcore; hot paths update with plain
+// stores, the reporter reads racily (a tick of skew does not matter)
+struct alignas(RTE_CACHE_LINE_SIZE) LcoreStats {
+  uint64_t tx_pkts{0};
+  uint64_t tx_bytes{0};
+  uint64_t rx_pkts{0};
+  uint64_t rx_bytes{0};
+  uint64_t ring_full{0};
+  uint64_t retransmits{0};
+  uint64_t alloc_failures{0};
+  uint64_t polls{0};
+  uint64_t empty_polls{0};
+  Histogram rtt_cycles;
+  // NIC-to-NIC wire latency in ns from hardware timestamps; excludes the
+  // software queueing that rtt_cycles includes
+  Histogram wire_ns;
+};
+
+inline LcoreStats g_lcore_stats[RTE_MAX_LCORE];
+
+inline LcoreStats &local() { return g_lcore_stats[rte_lcore_id()]; }
+
+// Reporter: aggregates all lcore blocks every interval, prints key:value
+// lines (the format analyze_results.py parses) and appends a CSV row.
+inline void report_once(FILE *csv, const LcoreStats &prev, LcoreStats &cur,
+                        double seconds) {
+  cur = LcoreStats{};
+  for (unsigned l = 0; l < RTE_MAX_LCORE; ++l) {
+    const LcoreStats &s = g_lcore_stats[l];
+    cur.tx_pkts += s.tx_pkts;
+    cur.tx_bytes += s.tx_bytes;
+    cur.rx_pkts += s.rx_pkts;
+    cur.rx_bytes += s.rx_bytes;
+    cur.ring_full += s.ring_full;
+    cur.retransmits += s.retransmits;
+    cur.alloc_failures += s.alloc_failures;
+    cur.polls += s.polls;
+    cur.empty_polls += s.empty_polls;
+    cur.rtt_cycles.merge(s.rtt_cycles);
+    cur.wire_ns.merge(s.wire_ns);
+  }
+
+  double hz = (double)rte_get_tsc_hz();
+  double to_us = 1e6 / hz;
+  double tx_pps = (double)(cur.tx_pkts - prev.tx_pkts) / seconds;
+  double rx_pps = (double)(cur.rx_pkts - prev.rx_pkts) / seconds;
+  double p50 = (double)cur.rtt_cycles.percentile(0.50) * to_us;
+  double p99 = (double)cur.rtt_cycles.percentile(0.99) * to_us;
+  double p999 = (double)cur.rtt_cycles.percentile(0.999) * to_us;
+  double wire_p50 = (double)cur.wire_ns.percentile(0.50) / 1e3;
+  double wire_p99 = (double)cur.wire_ns.percentile(0.99) / 1e3;
+  uint64_t polls = cur.polls - prev.polls;
+  double empty_ratio =
+      polls ? (double)(cur.empty_polls - prev.empty_polls) / (double)polls : 0;
+
+  printf("tx_pps: %.0f\n", tx_pps);
+  printf("rx_pps: %.0f\n", rx_pps);
+  printf("rtt_p50_us: %.2f\n", p50);
+  printf("rtt_p99_us: %.2f\n", p99);
+  printf("rtt_p999_us: %.2f\n", p999);
+  if (cur.wire_ns.total() > 0) {
+    printf("wire_p50_us: %.3f\n", wire_p50);
+    printf("wire_p99_us: %.3f\n", wire_p99);
+  }
+  printf("ring_full: %lu\n", (unsigned long)(cur.ring_full - prev.ring_full));
+  printf("empty_poll_ratio: %.3f\n", empty_ratio);
+  fflush(stdout);
+
+  if (csv) {
+    fprintf(csv, "%lu,%.0f,%.0f,%.2f,%.2f,%.2f,%.3f,%.3f,%lu,%lu,%lu,%.3f\n",
+            (unsigned long)time(nullptr), tx_pps, rx_pps, p50, p99, p999,
+            wire_p50, wire_p99,
+            (unsigned long)(cur.ring_full - prev.ring_full),
+            (unsigned long)(cur.retransmits - prev.retransmits),
+            (unsigned long)(cur.alloc_failures - prev.alloc_failures),
+            empty_ratio);
+    fflush(csv);
+  }
+}
+
+// Spawn the reporter on a plain std::thread (not a worker lcore); it sleeps
+// between rounds so it never competes with the data path
+inline void start_reporter(const char *csv_path, unsigned interval_s = 1) {
+  std::thread([csv_path, interval_s]() {
+    FILE *csv = nullptr;
+    if (csv_path) {
+      csv = fopen(csv_path, "a");
+      if (csv && ftell(csv) == 0)
+        fprintf(csv, "timestamp,tx_pps,rx_pps,rtt_p50_us,rtt_p99_us,"
+                     "rtt_p999_us,wire_p50_us,wire_p99_us,ring_full,"
+                     "retransmits,alloc_failures,empty_poll_ratio\n");
+    }
+    LcoreStats prev{};
+    LcoreStats cur{};
+    for (;;) {
+      std::this_thread::sleep_for(std::chrono::seconds(interval_s));
+      report_once(csv, prev, cur, (double)interval_s);
+      prev = cur;
+    }
+  }).detach();
+}
+
+} // namespace stats
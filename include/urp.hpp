@@ -1,19 +1,31 @@
 #pragma once
 
+#include <array>
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
 #include <cstdio>
+#include <rte_cycles.h>
 #include <rte_ethdev.h>
 #include <rte_ether.h>
 #include <rte_malloc.h>
 #include <rte_mbuf.h>
+#include <rte_mbuf_dyn.h>
 #include <rte_memcpy.h>
 #include <rte_mempool.h>
+#include <rte_prefetch.h>
 #include <rte_ring.h>
 #include <rte_ring_core.h>
+#include <rte_ring_peek_zc.h>
+#include <span>
+#include <string>
 #include <vector>
 
 #include "common.hpp"
+#include "flow.hpp"
+#include "impair.hpp"
+#include "numa.hpp"
+#include "stats.hpp"
 
 // Unreliable Reliable Protocol (URP) - Similar interface to SRP but without
 // ACKs
@@ -29,74 +41,305 @@ static constexpr uint16_t ETH_TYPE = 0x88B6; // Different from SRP
 
 static constexpr size_t MAX_PAYLOAD = 1024;
 
+// In-progress reassemblies held per RX queue
+static constexpr size_t NB_REASM_SLOTS = 8;
+
 struct Payload {
   size_t size;
   uint8_t data[MAX_PAYLOAD];
 };
 
+// Slot layout of the inline small-message ring: the bytes live in the ring
+// element itself instead of behind a Payload pointer (see
+// EndpointConfig::inline_size)
+struct InlineSlot {
+  uint32_t size;
+  uint8_t data[];
+};
+
 // Simple Unreliable Protocol Header (no ACK needed)
 struct urp_hdr {
   uint32_t seq;         // Sequence number for identification (not ordering)
   uint16_t version;     // Protocol version
   uint16_t opcode;      // Always OPCODE_DATA
   uint16_t payload_len; // Length of payload
+  uint32_t msg_id;      // Message a fragment belongs to (0 when unfragmented)
+  uint16_t frag_idx;    // Fragment index within the message
+  uint16_t frag_total;  // Total fragments in the message (1 = unfragmented)
   uint8_t payload[];
 };
 
-static inline int port_init(uint16_t port_id, struct rte_mempool *pool) {
+// Parsed view of a received frame: header fields in host order plus a
+// pointer into the mbuf payload — no header or payload copies
+struct FrameView {
+  bool ok;
+  uint16_t opcode;
+  uint16_t payload_len;
+  uint32_t seq;
+  uint32_t msg_id;
+  uint16_t frag_idx;
+  uint16_t frag_total;
+  uint8_t *payload;
+};
+
+// Reassembled multi-fragment message, delivered on the inbound ring.
+// Layout-compatible with Payload (size first) but data extends beyond
+// MAX_PAYLOAD; rte_malloc'd, consumer frees with rte_free.
+struct Message {
+  size_t size;
+  uint8_t data[];
+};
+
+static inline int port_init(uint16_t port_id, struct rte_mempool *pool,
+                            uint16_t nb_queues = 1, bool flow_steering = true,
+                            uint16_t mtu = RTE_ETHER_MTU,
+                            bool hw_timestamp = false, bool tx_fast_free = true,
+                            uint16_t nb_tx_queues = 0) {
+  // Asymmetric setups (one RX queue feeding many TX-capable workers, as in
+  // the event pipeline) pass nb_tx_queues; 0 keeps the paired default
+  uint16_t nb_tx = nb_tx_queues ? nb_tx_queues : nb_queues;
   struct rte_eth_conf port_conf{};
   port_conf.rxmode.mq_mode = RTE_ETH_MQ_RX_NONE;
+  port_conf.rxmode.mtu = mtu;
   port_conf.txmode.mq_mode = RTE_ETH_MQ_TX_NONE;
 
-  int ret = rte_eth_dev_configure(port_id, 1, 1, &port_conf);
+  struct rte_eth_dev_info dev_info{};
+  if (rte_eth_dev_info_get(port_id, &dev_info) < 0)
+    panic("Failed to get dev info for port %u", port_id);
+
+  if (hw_timestamp) {
+    // IEEE 1588: have the NIC stamp every received frame; the timestamps
+    // land in the mbuf dynfield the endpoint registered
+    if (!(dev_info.rx_offload_capa & RTE_ETH_RX_OFFLOAD_TIMESTAMP))
+      panic("port %u does not support RX timestamping", port_id);
+    port_conf.rxmode.offloads |= RTE_ETH_RX_OFFLOAD_TIMESTAMP;
+  }
+
+  if (tx_fast_free &&
+      (dev_info.tx_offload_capa & RTE_ETH_TX_OFFLOAD_MBUF_FAST_FREE)) {
+    // Fast-free TX completion: the PMD bulk-returns transmitted mbufs to
+    // their pool without walking refcounts or segments. Valid because every
+    // mbuf on a queue comes from that queue's dedicated pool, is
+    // single-segment, and has refcnt 1.
+    port_conf.txmode.offloads |= RTE_ETH_TX_OFFLOAD_MBUF_FAST_FREE;
+  }
+
+  if (nb_queues > 1) {
+    // Spread inbound frames across the RX queues with RSS. Our frames are
+    // plain L2, so hash on the L2 payload (which covers the URP seq); mask
+    // by what the PMD actually supports.
+    port_conf.rxmode.mq_mode = RTE_ETH_MQ_RX_RSS;
+    port_conf.rx_adv_conf.rss_conf.rss_key = nullptr;
+    port_conf.rx_adv_conf.rss_conf.rss_hf =
+        RTE_ETH_RSS_L2_PAYLOAD & dev_info.flow_type_rss_offloads;
+  }
+
+  int ret = rte_eth_dev_configure(port_id, nb_queues, nb_tx, &port_conf);
   if (ret < 0)
     panic("Failed to configure port %u", port_id);
-  ret = rte_eth_rx_queue_setup(port_id, 0, RX_DESC_DEFAULT,
-                               rte_eth_dev_socket_id(port_id), nullptr, pool);
-  if (ret < 0)
-    panic("Failed to setup RX queue for port %u", port_id);
-  ret = rte_eth_tx_queue_setup(port_id, 0, TX_DESC_DEFAULT,
-                               rte_eth_dev_socket_id(port_id), nullptr);
-  if (ret < 0)
-    panic("Failed to setup TX queue for port %u", port_id);
+  if (mtu != RTE_ETHER_MTU) {
+    ret = rte_eth_dev_set_mtu(port_id, mtu);
+    if (ret < 0)
+      panic("Failed to set MTU %u on port %u", mtu, port_id);
+  }
+  struct rte_eth_txconf tx_conf = dev_info.default_txconf;
+  tx_conf.offloads = port_conf.txmode.offloads;
+  // Recycle completed descriptors in half-ring batches instead of the PMD's
+  // small default; completion processing profiles at ~15% of the TX lcore
+  // and bigger batches amortize the walk (with fast-free it collapses to a
+  // handful of bulk mempool puts)
+  tx_conf.tx_free_thresh = TX_DESC_DEFAULT / 2;
+
+  for (uint16_t q = 0; q < nb_queues; ++q) {
+    ret = rte_eth_rx_queue_setup(port_id, q, RX_DESC_DEFAULT,
+                                 rte_eth_dev_socket_id(port_id), nullptr, pool);
+    if (ret < 0)
+      panic("Failed to setup RX queue %u for port %u", q, port_id);
+  }
+  for (uint16_t q = 0; q < nb_tx; ++q) {
+    ret = rte_eth_tx_queue_setup(port_id, q, TX_DESC_DEFAULT,
+                                 rte_eth_dev_socket_id(port_id), &tx_conf);
+    if (ret < 0)
+      panic("Failed to setup TX queue %u for port %u", q, port_id);
+  }
   ret = rte_eth_dev_start(port_id);
   if (ret < 0)
     panic("Failed to start port %u", port_id);
-  rte_eth_promiscuous_enable(port_id);
+  if (hw_timestamp && rte_eth_timesync_enable(port_id) < 0)
+    panic("Failed to enable timesync on port %u", port_id);
+  // Steer our EtherType in the NIC; promiscuous mode is only the fallback
+  // for PMDs without rte_flow support
+  if (!flow_steering || !flow_steer_ether_type(port_id, ETH_TYPE, nb_queues)) {
+    if (flow_steering)
+      printf("port %u: rte_flow steering unavailable, "
+             "falling back to promiscuous mode\n",
+             port_id);
+    rte_eth_promiscuous_enable(port_id);
+  }
   return port_id;
 }
 
 struct EndpointConfig {
   uint16_t port_id;
+  // Link aggregation: all member ports to the same peer. Empty means just
+  // port_id; otherwise port_id should be the first entry (it names the
+  // shared resources and provides the source MAC). TX spreads bursts
+  // round-robin across members and RX polls them all into one inbound ring.
+  std::vector<uint16_t> ports;
   // Default peer to send DATA to
   rte_ether_addr default_peer_mac;
+  // Number of RX/TX queue pairs; >1 enables RSS and one worker per queue
+  uint16_t nb_queues = 1;
   // Queue sizes
   uint32_t ring_size = 4096;
 
   uint32_t tx_burst_size = DEFAULT_BURST_SIZE;
   uint32_t rx_burst_size = DEFAULT_BURST_SIZE;
 
+  // Producer writes into mbuf payloads via tx_prepare()/tx_commit() instead
+  // of staging Payloads through the outbound ring
+  bool zero_copy_tx = false;
+
+  // Deliver received rte_mbuf* straight onto the inbound ring; the consumer
+  // reads payloads in place and returns them with rx_release()
+  bool zero_copy_rx = false;
+
+  // Steer our EtherType to the RX queues via rte_flow instead of running the
+  // port promiscuous (automatic fallback when the PMD lacks support)
+  bool flow_steering = true;
+
   size_t unit_size = 64;
+
+  // Back off through pause/short sleeps after sustained empty polls instead
+  // of burning the core at 100% on an idle link (see backoff.hpp)
+  bool adaptive_poll = false;
+
+  // Producer pacing: target offered load in packets/sec (0 = unpaced spin).
+  // rate_gbps is an alternative spelling converted from the wire frame size.
+  uint64_t rate_pps = 0;
+  double rate_gbps = 0;
+  // Sweep mode: walk a comma-separated pps list, sweep_secs at each rate,
+  // reporting per-rate throughput (latency comes from the stats histogram)
+  std::string rate_sweep;
+  uint32_t sweep_secs = 5;
+
+  // Link MTU; raise for jumbo frames (mbuf pools are sized from this)
+  uint16_t mtu = RTE_ETHER_MTU;
+  // Max payload bytes per frame; 0 derives it from the MTU
+  size_t max_payload = 0;
+
+  // IEEE 1588 hardware timestamping: enable port timesync, record NIC RX
+  // timestamps, and report NIC-to-NIC wire latency separately from the
+  // software RTT (both peers must run it, synced to the same grandmaster)
+  bool hw_timestamp = false;
+
+  // Advertise MBUF_FAST_FREE on the TX queues when the PMD supports it; the
+  // per-queue TX pools satisfy its single-pool rule. Off only for A/B runs.
+  bool tx_fast_free = true;
+
+  // Inline small messages: payloads up to this many bytes travel in the
+  // ring slots themselves (rte_ring_create_elem) via send_inline(), so tx()
+  // reads the bytes straight out of the ring — no pointer chase on dequeue
+  // and no allocator traffic per message. 0 disables the ring; larger
+  // messages take the pointer path either way. ~128 fits our telemetry
+  // records.
+  size_t inline_size = 0;
+
+  // Loss/reorder/duplication injection for protocol benchmarking; zeroed
+  // probabilities leave the data path untouched (see impair.hpp)
+  ImpairConfig impair;
+
+  // Event-driven execution: instead of the fixed tx/rx/responder lcore
+  // topology, RX bursts become rte_eventdev events and the parse and
+  // application stages run on whichever worker lcore dequeues them, so
+  // rebalancing is a core-count change (see event-pipeline.hpp)
+  bool event_pipeline = false;
+  // Worker lcores for the event pipeline; 0 takes every lcore left over
+  // after the main lcore and the RX injector
+  uint16_t nb_event_workers = 0;
 };
 
 class URPEndpoint {
 public:
   explicit URPEndpoint(const EndpointConfig &cfg) {
-    tx_mbuf_pool_ = rte_pktmbuf_pool_create("URP_TX_MBUF_POOL", 2048, 128, 0,
-                                            2048, rte_socket_id());
-    if (!tx_mbuf_pool_)
-      panic("%s %s", "Failed to create URP TX mbuf pool",
-            rte_strerror(rte_errno));
+    // Size mbuf data rooms from the configured MTU so jumbo frames fit in a
+    // single segment
+    uint16_t buf_size = (uint16_t)RTE_ALIGN_CEIL(
+        RTE_PKTMBUF_HEADROOM + RTE_ETHER_HDR_LEN + cfg.mtu,
+        RTE_CACHE_LINE_SIZE);
+    if (buf_size < RTE_MBUF_DEFAULT_BUF_SIZE)
+      buf_size = RTE_MBUF_DEFAULT_BUF_SIZE;
+
+    max_payload_ = cfg.max_payload
+                       ? cfg.max_payload
+                       : (size_t)cfg.mtu - sizeof(urp_hdr);
+
+    ports_ = cfg.ports.empty() ? std::vector<uint16_t>{cfg.port_id}
+                               : cfg.ports;
 
-    rx_mbuf_pool_ = rte_pktmbuf_pool_create("URP_RX_MBUF_POOL", 2048, 128, 0,
-                                            2048, rte_socket_id());
+    // Place everything the NIC DMAs into — and the rings the workers poll —
+    // on the NIC's node, not the node of whichever core runs the ctor.
+    // Aggregated ports are expected to sit on the same node; the first
+    // member decides.
+    int socket = port_socket_id(ports_[0]);
+
+    // All resource names carry the port id so several endpoints can share
+    // one process (and one EAL hugepage reservation)
+    char tx_pool_name[64];
+    char rx_pool_name[64];
+    snprintf(rx_pool_name, sizeof(rx_pool_name), "urp_rx_mbuf_%u",
+             cfg.port_id);
+    // One TX pool per port and queue: MBUF_FAST_FREE requires every mbuf
+    // completed on a queue to come from one pool, and it keeps each TX
+    // worker's mempool fast-path cache on its own lcore instead of bouncing
+    // a shared one
+    tx_mbuf_pools_.resize(ports_.size() * cfg.nb_queues);
+    for (size_t p = 0; p < ports_.size(); ++p) {
+      for (uint16_t q = 0; q < cfg.nb_queues; ++q) {
+        snprintf(tx_pool_name, sizeof(tx_pool_name), "urp_tx_mbuf_%u_q%u",
+                 ports_[p], q);
+        struct rte_mempool *&pool = tx_mbuf_pools_[p * cfg.nb_queues + q];
+        pool = rte_pktmbuf_pool_create(tx_pool_name, 2048, 128, 0, buf_size,
+                                       socket);
+        if (!pool)
+          panic("%s %s", "Failed to create URP TX mbuf pool",
+                rte_strerror(rte_errno));
+      }
+    }
+
+    rx_mbuf_pool_ = rte_pktmbuf_pool_create(rx_pool_name, 2048, 128, 0,
+                                            buf_size, socket);
     if (!rx_mbuf_pool_)
       panic("%s %s", "Failed to create URP RX mbuf pool",
             rte_strerror(rte_errno));
 
+    // Payload staging objects come from a per-lcore-cached mempool rather
+    // than the rte_malloc heap
+    char pool_name[64];
+    snprintf(pool_name, sizeof(pool_name), "urp_payload_%u", cfg.port_id);
+    payload_pool_ = rte_mempool_create(pool_name, 8192 - 1, sizeof(Payload),
+                                       256, 0, NULL, NULL, NULL, NULL, socket,
+                                       0);
+    if (!payload_pool_)
+      panic("%s %s", "Failed to create URP payload pool",
+            rte_strerror(rte_errno));
+
     cfg_ = cfg;
-    port_init(cfg.port_id, rx_mbuf_pool_);
-    rte_eth_macaddr_get(cfg.port_id, &src_mac_);
+    // The dynfield must exist before the port is configured with the
+    // timestamp offload
+    if (cfg.hw_timestamp &&
+        rte_mbuf_dyn_rx_timestamp_register(&hwts_offset_, &hwts_rx_flag_) < 0)
+      panic("Failed to register RX timestamp dynfield");
+    // Duplication injection transmits the same mbuf twice via a refcnt
+    // bump, which breaks fast-free's refcnt==1 rule; fall back to normal
+    // TX completions for those runs
+    bool tx_fast_free = cfg.tx_fast_free && !(cfg.impair.dup_prob > 0.0);
+    for (uint16_t port : ports_)
+      port_init(port, rx_mbuf_pool_, cfg.nb_queues, cfg.flow_steering,
+                cfg.mtu, cfg.hw_timestamp, tx_fast_free);
+    // One identity for the aggregate: all frames carry the first member's
+    // MAC, so the peer learns a single return address
+    rte_eth_macaddr_get(ports_[0], &src_mac_);
     peer_mac_default_ = cfg.default_peer_mac;
 
     char in_name[64];
@@ -104,28 +347,80 @@ public:
     snprintf(in_name, sizeof(in_name), "urp_in_%u", cfg_.port_id);
     snprintf(out_name, sizeof(out_name), "urp_out_%u", cfg_.port_id);
 
-    inbound_ring_ = rte_ring_create(in_name, cfg.ring_size, rte_socket_id(),
-                                    RING_F_SC_DEQ | RING_F_SP_ENQ);
+    // With more than one queue pair the RX workers enqueue inbound
+    // concurrently and the TX workers dequeue outbound concurrently, so only
+    // the app-facing side of each ring stays single-threaded.
+    unsigned in_flags =
+        RING_F_SC_DEQ | (cfg.nb_queues > 1 ? 0 : RING_F_SP_ENQ);
+    unsigned out_flags =
+        RING_F_SP_ENQ | (cfg.nb_queues > 1 ? 0 : RING_F_SC_DEQ);
+
+    inbound_ring_ =
+        rte_ring_create(in_name, cfg.ring_size, socket, in_flags);
     if (!inbound_ring_)
       panic("Failed to create URP inbound ring");
 
-    outbound_ring_ = rte_ring_create(out_name, cfg.ring_size, rte_socket_id(),
-                                     RING_F_SP_ENQ | RING_F_SC_DEQ);
+    outbound_ring_ =
+        rte_ring_create(out_name, cfg.ring_size, socket, out_flags);
     if (!outbound_ring_)
       panic("Failed to create URP outbound ring");
 
-    tx_payloads_ptr_buf = std::vector<Payload *>(cfg.tx_burst_size);
-    tx_bufs_ptr_buf = std::vector<struct rte_mbuf *>(cfg.tx_burst_size);
-    rx_payloads_ptr_buf = std::vector<Payload *>(cfg.rx_burst_size);
-    for (uint32_t i = 0; i < cfg.rx_burst_size; ++i) {
-      rx_payloads_ptr_buf[i] =
-          (Payload *)rte_zmalloc(NULL, sizeof(Payload), RTE_CACHE_LINE_SIZE);
+    if (cfg.inline_size) {
+      // Slot = length word + bytes, padded to 8 as rte_ring_create_elem
+      // wants. SP/SC regardless of queue count — zero-copy slot access
+      // needs single-threaded ends, so queue 0 alone drains this ring.
+      inline_esize_ =
+          (uint32_t)RTE_ALIGN_CEIL(sizeof(InlineSlot) + cfg.inline_size, 8);
+      char inl_name[64];
+      snprintf(inl_name, sizeof(inl_name), "urp_inl_%u", cfg.port_id);
+      inline_ring_ =
+          rte_ring_create_elem(inl_name, inline_esize_, cfg.ring_size, socket,
+                               RING_F_SP_ENQ | RING_F_SC_DEQ);
+      if (!inline_ring_)
+        panic("Failed to create URP inline ring");
     }
-    rx_bufs_ptr_buf = std::vector<struct rte_mbuf *>(cfg.rx_burst_size);
+
+    queues_.resize(cfg.nb_queues);
+    for (auto &q : queues_) {
+      q.tx_payloads_ptr_buf = std::vector<Payload *>(cfg.tx_burst_size);
+      q.tx_bufs_ptr_buf = std::vector<struct rte_mbuf *>(cfg.tx_burst_size);
+      q.rx_payloads_ptr_buf = std::vector<Payload *>(cfg.rx_burst_size);
+      if (rte_mempool_get_bulk(payload_pool_,
+                               (void **)q.rx_payloads_ptr_buf.data(),
+                               cfg.rx_burst_size) < 0)
+        panic("Failed to get URP RX payloads from pool");
+      q.rx_bufs_ptr_buf = std::vector<struct rte_mbuf *>(cfg.rx_burst_size);
+      q.zc_tx_regions = std::vector<uint8_t *>(cfg.tx_burst_size);
+    }
+
+    // Pre-build the ether+urp header image once; tx copies it into each
+    // frame and patches only dst/seq/payload_len
+    struct rte_ether_hdr *teth = (struct rte_ether_hdr *)tx_hdr_template_;
+    rte_ether_addr_copy(&peer_mac_default_, &teth->dst_addr);
+    rte_ether_addr_copy(&src_mac_, &teth->src_addr);
+    teth->ether_type = rte_cpu_to_be_16(ETH_TYPE);
+    urp_hdr *tuh = (urp_hdr *)(teth + 1);
+    tuh->version = rte_cpu_to_be_16(1);
+    tuh->opcode = rte_cpu_to_be_16(OPCODE_DATA);
+    tuh->seq = 0;
+    tuh->payload_len = 0;
+    tuh->msg_id = 0;
+    tuh->frag_idx = 0;
+    tuh->frag_total = rte_cpu_to_be_16(1);
+
+    // Each queue worker patches dst into its own template copy; sharing one
+    // image across TX lcores would race the patch against the memcpy
+    for (auto &q : queues_)
+      rte_memcpy(q.tx_hdr_template, tx_hdr_template_,
+                 sizeof(tx_hdr_template_));
 
     // Initialize state
     tx_seq_ = 0;
     have_learned_peer_ = false;
+    // A message arrives as one TX burst, so 10ms of silence means a
+    // fragment is gone, not late; the slot is then fair game for eviction
+    reasm_timeout_cycles_ = rte_get_timer_hz() / 100;
+    impair_.configure(cfg.impair);
   }
 
   // Non-copyable
@@ -137,96 +432,537 @@ public:
   rte_ring *inbound_ring() const { return inbound_ring_; }
   rte_ring *outbound_ring() const { return outbound_ring_; }
 
-  // Main progress function - call this repeatedly
-  void progress() {
-    tx();
-    rx();
+  // Payload allocator for application producers/consumers
+  Payload *payload_alloc() {
+    void *obj = nullptr;
+    if (rte_mempool_get(payload_pool_, &obj) < 0)
+      return nullptr;
+    return (Payload *)obj;
   }
+  void payload_free(Payload *p) { rte_mempool_put(payload_pool_, p); }
 
-  std::vector<Payload *> tx_payloads_ptr_buf;
-  std::vector<struct rte_mbuf *> tx_bufs_ptr_buf;
-  std::vector<Payload *> rx_payloads_ptr_buf;
-  std::vector<struct rte_mbuf *> rx_bufs_ptr_buf;
+  // Small-message fast path: write len bytes into an inline ring slot in
+  // place (zero-copy enqueue). Returns false when the message is too big
+  // for a slot — caller falls back to the Payload pointer path — or the
+  // ring is full. Single producer, like the outbound ring.
+  bool send_inline(const uint8_t *data, size_t len) {
+    if (!inline_ring_ || len > cfg_.inline_size)
+      return false;
+    struct rte_ring_zc_data zcd;
+    if (rte_ring_enqueue_zc_burst_elem_start(inline_ring_, inline_esize_, 1,
+                                             &zcd, nullptr) == 0)
+      return false;
+    InlineSlot *slot = (InlineSlot *)zcd.ptr1;
+    slot->size = (uint32_t)len;
+    rte_memcpy(slot->data, data, len);
+    rte_ring_enqueue_zc_elem_finish(inline_ring_, 1);
+    return true;
+  }
 
-  void tx() {
-    uint32_t nb_payloads = 0;
-    // Send packets from outbound ring - fire and forget, no ACK handling
+  // Current time of the port's PTP clock in ns. Producers embed this in the
+  // payload (bytes 8..15) so the receive side can compute NIC-to-NIC wire
+  // latency against its own RX timestamp.
+  uint64_t ptp_time_ns() const {
+    struct timespec ts;
+    if (rte_eth_timesync_read_time(cfg_.port_id, &ts) < 0)
+      return 0;
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+  }
 
-    if ((nb_payloads = rte_ring_sc_dequeue_burst(
-             outbound_ring_, (void **)tx_payloads_ptr_buf.data(),
-             cfg_.tx_burst_size, nullptr)) != 0) {
-      const rte_ether_addr *dst =
-          have_learned_peer_ ? &learned_peer_ : &peer_mac_default_;
+  // Main progress function - call this repeatedly; returns the number of
+  // packets moved so callers can drive idle backoff
+  uint32_t progress() { return tx() + rx(); }
 
-      for (uint32_t i = 0; i < nb_payloads; ++i) {
+  // Per-queue staging buffers so each worker lcore can drive its own queue
+  struct QueueBufs {
+    std::vector<Payload *> tx_payloads_ptr_buf;
+    std::vector<struct rte_mbuf *> tx_bufs_ptr_buf;
+    std::vector<Payload *> rx_payloads_ptr_buf;
+    std::vector<struct rte_mbuf *> rx_bufs_ptr_buf;
+    std::vector<uint8_t *> zc_tx_regions;
+    uint16_t zc_prepared{0};
+    // Member-port index the last tx_prepare() drew its mbufs from
+    uint32_t zc_port_idx{0};
 
-        if (tx_payloads_ptr_buf[i]->size <
-            sizeof(urp_hdr) + sizeof(struct rte_ether_hdr)) {
-          panic("Unit size is too small %d", tx_payloads_ptr_buf[i]->size);
-        }
+    // Per-queue copy of the pre-built header image; the TX worker patches
+    // dst in place without racing the other queues
+    uint8_t tx_hdr_template[sizeof(struct rte_ether_hdr) + sizeof(urp_hdr)]{};
 
-        struct rte_mbuf *m =
-            build_data_frame(dst, tx_payloads_ptr_buf[i], tx_seq_++);
-        if (!m) {
-          panic("Failed to build data frame");
-        }
-        tx_bufs_ptr_buf[i] = m;
+    // Reassembly table; fragments of one message must arrive on the same
+    // queue (single-queue configs, or flow steering that keeps a message's
+    // fragments together)
+    struct ReasmSlot {
+      bool in_use{false};
+      uint32_t msg_id{0};
+      uint16_t total{0};
+      uint16_t received{0};
+      size_t len{0};
+      Message *msg{nullptr};
+      // Per-fragment receipt bitmap ((total+63)/64 words) so duplicated
+      // fragments cannot double-count toward completion
+      uint64_t *seen{nullptr};
+      // Cycle stamp of the last accepted fragment, for slot aging
+      uint64_t last_frag_cycles{0};
+    };
+    ReasmSlot reasm[NB_REASM_SLOTS];
+  };
+  std::vector<QueueBufs> queues_;
+
+  // Dispatch to a compile-time burst-size kernel when the configured burst
+  // matches one of the sizes bench.zsh sweeps; odd sizes take the generic
+  // heap-staged path
+  uint32_t tx(uint16_t queue_id = 0) {
+    uint32_t moved = (inline_ring_ && queue_id == 0) ? tx_inline() : 0;
+    switch (cfg_.tx_burst_size) {
+    case 1:
+      return moved + tx_kernel<1>(queue_id);
+    case 2:
+      return moved + tx_kernel<2>(queue_id);
+    case 4:
+      return moved + tx_kernel<4>(queue_id);
+    case 8:
+      return moved + tx_kernel<8>(queue_id);
+    case 16:
+      return moved + tx_kernel<16>(queue_id);
+    case 32:
+      return moved + tx_kernel<32>(queue_id);
+    case 64:
+      return moved + tx_kernel<64>(queue_id);
+    case 128:
+      return moved + tx_kernel<128>(queue_id);
+    case 256:
+      return moved + tx_kernel<256>(queue_id);
+    default:
+      return moved + tx_generic(queue_id);
+    }
+  }
+
+  // Inline fast path: peek the occupied slots in place (zero-copy dequeue),
+  // build frames straight from the ring storage, then release the slots —
+  // the engine never dereferences a Payload pointer for these messages
+  uint32_t tx_inline() {
+    struct rte_ring_zc_data zcd;
+    uint32_t n = rte_ring_dequeue_zc_burst_elem_start(
+        inline_ring_, inline_esize_, cfg_.tx_burst_size, &zcd, nullptr);
+    if (n == 0)
+      return 0;
+
+    QueueBufs &q = queues_[0];
+    struct rte_ether_hdr *teth = (struct rte_ether_hdr *)q.tx_hdr_template;
+    rte_ether_addr_copy(have_learned_peer_.load(std::memory_order_acquire)
+                            ? &learned_peer_
+                            : &peer_mac_default_,
+                        &teth->dst_addr);
+
+    struct rte_mbuf **bufs = q.tx_bufs_ptr_buf.data();
+    uint32_t p = next_tx_port();
+    if (rte_pktmbuf_alloc_bulk(tx_mbuf_pools_[p * cfg_.nb_queues], bufs, n) !=
+        0)
+      panic("Failed to bulk-allocate TX mbufs");
+    uint32_t seq = tx_seq_.fetch_add(n, std::memory_order_relaxed);
+
+    for (uint32_t i = 0; i < n; ++i) {
+      // The reserved slots come back as up to two runs when the ring wraps
+      uint8_t *base = (uint8_t *)(i < zcd.n1 ? zcd.ptr1 : zcd.ptr2);
+      uint32_t idx = i < zcd.n1 ? i : i - zcd.n1;
+      InlineSlot *slot = (InlineSlot *)(base + (size_t)idx * inline_esize_);
+
+      struct rte_mbuf *m = bufs[i];
+      size_t frame_len =
+          sizeof(struct rte_ether_hdr) + sizeof(urp_hdr) + slot->size;
+      rte_pktmbuf_reset_headroom(m);
+      char *data = rte_pktmbuf_append(m, frame_len);
+      if (!data)
+        panic("Failed to append mbuf");
+      rte_memcpy(data, q.tx_hdr_template, sizeof(q.tx_hdr_template));
+      urp_hdr *uh = (urp_hdr *)((struct rte_ether_hdr *)data + 1);
+      uh->seq = rte_cpu_to_be_32(seq + i);
+      uh->payload_len = rte_cpu_to_be_16(slot->size);
+      rte_memcpy(uh->payload, slot->data, slot->size);
+    }
+    rte_ring_dequeue_zc_elem_finish(inline_ring_, n);
+
+    uint16_t sent = 0;
+    while (sent < n) {
+      sent += impair_.tx_burst(ports_[p], 0, bufs + sent, n - sent);
+    }
+
+    stats::LcoreStats &ls = stats::local();
+    ls.tx_pkts += n;
+    ls.tx_bytes += (uint64_t)n * cfg_.unit_size;
+    return n;
+  }
+
+  // Fixed-burst kernel: the staging arrays live on the stack and every ring
+  // and mempool call sees a compile-time count
+  template <size_t N> uint32_t tx_kernel(uint16_t queue_id) {
+    std::array<Payload *, N> payloads;
+    std::array<struct rte_mbuf *, N> bufs;
+    uint32_t nb_payloads = rte_ring_dequeue_burst(
+        outbound_ring_, (void **)payloads.data(), N, nullptr);
+    if (nb_payloads != 0)
+      tx_process(bufs.data(), payloads.data(), nb_payloads, queue_id);
+    return nb_payloads;
+  }
+
+  uint32_t tx_generic(uint16_t queue_id = 0) {
+    QueueBufs &q = queues_[queue_id];
+    uint32_t nb_payloads = rte_ring_dequeue_burst(
+        outbound_ring_, (void **)q.tx_payloads_ptr_buf.data(),
+        cfg_.tx_burst_size, nullptr);
+    if (nb_payloads != 0)
+      tx_process(q.tx_bufs_ptr_buf.data(), q.tx_payloads_ptr_buf.data(),
+                 nb_payloads, queue_id);
+    return nb_payloads;
+  }
+
+  // Build frames for a dequeued burst and put them on the wire; shared by
+  // the fixed-burst kernels and the generic path. Fire and forget, no ACKs.
+  void tx_process(struct rte_mbuf **bufs, Payload **payloads,
+                  uint32_t nb_payloads, uint16_t queue_id) {
+    // Patch this queue's header template dst once per burst
+    QueueBufs &q = queues_[queue_id];
+    struct rte_ether_hdr *teth = (struct rte_ether_hdr *)q.tx_hdr_template;
+    rte_ether_addr_copy(have_learned_peer_.load(std::memory_order_acquire)
+                            ? &learned_peer_
+                            : &peer_mac_default_,
+                        &teth->dst_addr);
+
+    // Spread bursts round-robin across the member ports; whole bursts (not
+    // single frames) so each port still sees full-burst TX calls
+    uint32_t p = next_tx_port();
+    uint16_t port = ports_[p];
+
+    // One mempool round trip for the whole burst, from this port+queue pool
+    if (rte_pktmbuf_alloc_bulk(tx_mbuf_pools_[p * cfg_.nb_queues + queue_id],
+                               bufs, nb_payloads) != 0)
+      panic("Failed to bulk-allocate TX mbufs");
+
+    // One relaxed fetch-add per burst; seq only identifies, not orders
+    uint32_t seq = tx_seq_.fetch_add(nb_payloads, std::memory_order_relaxed);
+
+    for (uint32_t i = 0; i < nb_payloads; ++i) {
+
+      if (payloads[i]->size <
+          sizeof(urp_hdr) + sizeof(struct rte_ether_hdr)) {
+        panic("Unit size is too small %d", payloads[i]->size);
       }
-      uint16_t sent = 0;
 
-      while (sent < nb_payloads) {
-        sent += rte_eth_tx_burst(cfg_.port_id, 0, tx_bufs_ptr_buf.data() + sent,
-                                 nb_payloads - sent);
+      if (i + 1 < nb_payloads)
+        rte_prefetch0(rte_pktmbuf_mtod(bufs[i + 1], void *));
+
+      fill_data_frame(bufs[i], payloads[i], seq + i, q.tx_hdr_template);
+    }
+    uint16_t sent = 0;
+
+    while (sent < nb_payloads) {
+      sent += impair_.tx_burst(port, queue_id, bufs + sent,
+                               nb_payloads - sent);
+    }
+
+    stats::LcoreStats &ls = stats::local();
+    ls.tx_pkts += nb_payloads;
+    ls.tx_bytes += (uint64_t)nb_payloads * cfg_.unit_size;
+  }
+
+  // Zero-copy TX: tx_prepare() bulk-allocates frames with headers already
+  // written and hands back the payload regions; the app writes message bytes
+  // directly into them (no Payload staging copy) and tx_commit() puts the
+  // frames on the wire. One caller at a time per queue.
+  uint16_t tx_prepare(uint16_t n, uint16_t payload_len, uint16_t queue_id = 0) {
+    if (n > cfg_.tx_burst_size)
+      n = cfg_.tx_burst_size;
+    QueueBufs &q = queues_[queue_id];
+    // Pick the member port now: the mbufs must come from that port's pool
+    // so tx_commit() keeps the fast-free single-pool rule
+    q.zc_port_idx = next_tx_port();
+    if (rte_pktmbuf_alloc_bulk(
+            tx_mbuf_pools_[q.zc_port_idx * cfg_.nb_queues + queue_id],
+            q.tx_bufs_ptr_buf.data(), n) != 0)
+      return 0;
+
+    const rte_ether_addr *dst =
+        have_learned_peer_.load(std::memory_order_acquire) ? &learned_peer_
+                                                           : &peer_mac_default_;
+    size_t frame_len =
+        sizeof(struct rte_ether_hdr) + sizeof(urp_hdr) + payload_len;
+    uint32_t seq = tx_seq_.fetch_add(n, std::memory_order_relaxed);
+
+    for (uint16_t i = 0; i < n; ++i) {
+      struct rte_mbuf *m = q.tx_bufs_ptr_buf[i];
+      rte_pktmbuf_reset_headroom(m);
+      char *data = rte_pktmbuf_append(m, frame_len);
+      if (!data)
+        panic("Failed to append mbuf");
+      struct rte_ether_hdr *eth = (struct rte_ether_hdr *)data;
+      rte_ether_addr_copy(dst, &eth->dst_addr);
+      rte_ether_addr_copy(&src_mac_, &eth->src_addr);
+      eth->ether_type = rte_cpu_to_be_16(ETH_TYPE);
+      urp_hdr *uh = (urp_hdr *)(eth + 1);
+      uh->version = rte_cpu_to_be_16(1);
+      uh->opcode = rte_cpu_to_be_16(OPCODE_DATA);
+      uh->seq = rte_cpu_to_be_32(seq + i);
+      uh->payload_len = rte_cpu_to_be_16(payload_len);
+      uh->msg_id = 0;
+      uh->frag_idx = 0;
+      uh->frag_total = rte_cpu_to_be_16(1);
+      q.zc_tx_regions[i] = uh->payload;
+    }
+    q.zc_prepared = n;
+    return n;
+  }
+
+  // Payload regions handed out by the last tx_prepare() on this queue
+  std::span<uint8_t *const> tx_regions(uint16_t queue_id = 0) {
+    QueueBufs &q = queues_[queue_id];
+    return std::span<uint8_t *const>(q.zc_tx_regions.data(), q.zc_prepared);
+  }
+
+  // Send the first n prepared frames; any remainder goes back to the pool
+  void tx_commit(uint16_t n, uint16_t queue_id = 0) {
+    QueueBufs &q = queues_[queue_id];
+    if (n > q.zc_prepared)
+      n = q.zc_prepared;
+    if (cfg_.hw_timestamp) {
+      // The producer has finished writing the payload regions, so this is
+      // the last point before the wire; stamp bytes 8..15 of each frame
+      // with NIC PTP time (one read per commit, shared across the burst)
+      uint64_t ns = ptp_time_ns();
+      for (uint16_t i = 0; i < n; ++i) {
+        size_t plen = rte_pktmbuf_pkt_len(q.tx_bufs_ptr_buf[i]) -
+                      sizeof(struct rte_ether_hdr) - sizeof(urp_hdr);
+        if (plen >= 16)
+          rte_memcpy(q.zc_tx_regions[i] + 8, &ns, sizeof(ns));
       }
     }
+    uint16_t sent = 0;
+    while (sent < n) {
+      sent += impair_.tx_burst(ports_[q.zc_port_idx], queue_id,
+                               q.tx_bufs_ptr_buf.data() + sent, n - sent);
+    }
+    if (n < q.zc_prepared)
+      rte_pktmbuf_free_bulk(q.tx_bufs_ptr_buf.data() + n, q.zc_prepared - n);
+    q.zc_prepared = 0;
   }
 
-  void rx() {
-    // Receive packets and enqueue to inbound ring - no ACK needed
-    uint16_t nb_rx = rte_eth_rx_burst(cfg_.port_id, 0, rx_bufs_ptr_buf.data(),
-                                      cfg_.rx_burst_size);
+  // Fragment a message larger than MAX_PAYLOAD across multiple frames and
+  // put them on the wire as one burst; the receive side reassembles and
+  // delivers a single contiguous Message on its inbound ring
+  bool send_message(const uint8_t *data, size_t len, uint16_t queue_id = 0) {
+    // Fragment size follows the configured max payload; both peers must run
+    // the same MTU for offsets to line up
+    uint32_t nfrags = (uint32_t)((len + max_payload_ - 1) / max_payload_);
+    if (nfrags == 0)
+      nfrags = 1;
+    QueueBufs &q = queues_[queue_id];
+    if (nfrags > cfg_.tx_burst_size)
+      return false; // one TX burst per message
 
-    for (uint16_t i = 0; i < nb_rx; ++i) {
-      struct rte_mbuf *m = rx_bufs_ptr_buf[i];
-      urp_hdr rcv = parse_frame(m);
-      if (rcv.opcode == OPCODE_DATA) {
-        // Learn peer MAC from frame src
-        struct rte_ether_hdr *eth = rte_pktmbuf_mtod(m, struct rte_ether_hdr *);
-        if (!have_learned_peer_) {
-          rte_ether_addr_copy(&eth->src_addr, &learned_peer_);
-          have_learned_peer_ = true;
+    // One port per message: fragments stay on one link, so they arrive
+    // roughly in order and the reassembly slots fill without churn
+    uint32_t p = next_tx_port();
+    if (rte_pktmbuf_alloc_bulk(tx_mbuf_pools_[p * cfg_.nb_queues + queue_id],
+                               q.tx_bufs_ptr_buf.data(), nfrags) != 0) {
+      stats::local().alloc_failures++;
+      return false;
+    }
+
+    struct rte_ether_hdr *teth = (struct rte_ether_hdr *)q.tx_hdr_template;
+    rte_ether_addr_copy(have_learned_peer_.load(std::memory_order_acquire)
+                            ? &learned_peer_
+                            : &peer_mac_default_,
+                        &teth->dst_addr);
+    uint32_t msg_id = next_msg_id_.fetch_add(1, std::memory_order_relaxed) + 1;
+    uint32_t seq = tx_seq_.fetch_add(nfrags, std::memory_order_relaxed);
+
+    for (uint32_t f = 0; f < nfrags; ++f) {
+      size_t off = (size_t)f * max_payload_;
+      size_t chunk = len - off < max_payload_ ? len - off : max_payload_;
+      struct rte_mbuf *m = q.tx_bufs_ptr_buf[f];
+      rte_pktmbuf_reset_headroom(m);
+      char *frame = rte_pktmbuf_append(
+          m, sizeof(struct rte_ether_hdr) + sizeof(urp_hdr) + chunk);
+      if (!frame)
+        panic("Failed to append mbuf");
+      rte_memcpy(frame, q.tx_hdr_template, sizeof(q.tx_hdr_template));
+      urp_hdr *uh = (urp_hdr *)((struct rte_ether_hdr *)frame + 1);
+      uh->seq = rte_cpu_to_be_32(seq + f);
+      uh->payload_len = rte_cpu_to_be_16(chunk);
+      uh->msg_id = rte_cpu_to_be_32(msg_id);
+      uh->frag_idx = rte_cpu_to_be_16(f);
+      uh->frag_total = rte_cpu_to_be_16(nfrags);
+      rte_memcpy(uh->payload, data + off, chunk);
+    }
+
+    uint16_t sent = 0;
+    while (sent < nfrags) {
+      sent += impair_.tx_burst(ports_[p], queue_id,
+                               q.tx_bufs_ptr_buf.data() + sent, nfrags - sent);
+    }
+    stats::LcoreStats &ls = stats::local();
+    ls.tx_pkts += nfrags;
+    ls.tx_bytes += len;
+    return true;
+  }
+
+  // View of the URP payload carried by a received mbuf (zero-copy RX mode)
+  static std::span<uint8_t> payload_view(struct rte_mbuf *m) {
+    struct rte_ether_hdr *eth = rte_pktmbuf_mtod(m, struct rte_ether_hdr *);
+    urp_hdr *uh = (urp_hdr *)(eth + 1);
+    return std::span<uint8_t>(uh->payload, rte_be_to_cpu_16(uh->payload_len));
+  }
+
+  // Return consumed mbufs to their pool in bulk (zero-copy RX mode)
+  static void rx_release(struct rte_mbuf **bufs, uint16_t n) {
+    rte_pktmbuf_free_bulk(bufs, n);
+  }
+
+  // Same dispatch as tx(): fixed-burst kernels for the swept sizes, generic
+  // fallback for the rest
+  uint32_t rx(uint16_t queue_id = 0) {
+    switch (cfg_.rx_burst_size) {
+    case 1:
+      return rx_kernel<1>(queue_id);
+    case 2:
+      return rx_kernel<2>(queue_id);
+    case 4:
+      return rx_kernel<4>(queue_id);
+    case 8:
+      return rx_kernel<8>(queue_id);
+    case 16:
+      return rx_kernel<16>(queue_id);
+    case 32:
+      return rx_kernel<32>(queue_id);
+    case 64:
+      return rx_kernel<64>(queue_id);
+    case 128:
+      return rx_kernel<128>(queue_id);
+    case 256:
+      return rx_kernel<256>(queue_id);
+    default:
+      return rx_generic(queue_id);
+    }
+  }
+
+  // Both paths poll every member port into the shared inbound ring, so the
+  // aggregate looks like one link to the application
+  template <size_t N> uint32_t rx_kernel(uint16_t queue_id) {
+    std::array<struct rte_mbuf *, N> bufs;
+    uint32_t total = 0;
+    for (uint16_t port : ports_) {
+      uint16_t nb_rx = impair_.rx_burst(port, queue_id, bufs.data(), N);
+      if (nb_rx != 0)
+        rx_process(queues_[queue_id], bufs.data(), nb_rx);
+      total += nb_rx;
+    }
+    return total;
+  }
+
+  uint32_t rx_generic(uint16_t queue_id = 0) {
+    QueueBufs &q = queues_[queue_id];
+    uint32_t total = 0;
+    for (uint16_t port : ports_) {
+      uint16_t nb_rx = impair_.rx_burst(port, queue_id,
+                                        q.rx_bufs_ptr_buf.data(),
+                                        cfg_.rx_burst_size);
+      if (nb_rx != 0)
+        rx_process(q, q.rx_bufs_ptr_buf.data(), nb_rx);
+      total += nb_rx;
+    }
+    return total;
+  }
+
+  // Parse and deliver one received burst; shared by the fixed-burst kernels
+  // and the generic path
+  void rx_process(QueueBufs &q, struct rte_mbuf **bufs, uint16_t nb_rx) {
+    // Vector-PMD-style parse pipeline: packet data is prefetched two
+    // iterations before it is parsed, so the header loads below hit L1
+    for (uint16_t i = 0; i < nb_rx && i < 2; ++i)
+      rte_prefetch0(rte_pktmbuf_mtod(bufs[i], void *));
+
+    if (cfg_.zero_copy_rx) {
+      // Hand the mbufs themselves to the application; it reads payloads in
+      // place and frees them via rx_release()
+      uint16_t kept = 0;
+      for (uint16_t i = 0; i < nb_rx; ++i) {
+        if (i + 2 < nb_rx)
+          rte_prefetch0(rte_pktmbuf_mtod(bufs[i + 2], void *));
+        struct rte_mbuf *m = bufs[i];
+        FrameView rcv = parse_frame(m);
+        if (!rcv.ok || rcv.opcode != OPCODE_DATA) {
+          rte_pktmbuf_free(m);
+          continue;
         }
+        if (!have_learned_peer_.load(std::memory_order_relaxed))
+          learn_peer(rte_pktmbuf_mtod(m, struct rte_ether_hdr *));
+        bufs[kept++] = m;
+      }
+      uint32_t num_enqueued = 0;
+      while (num_enqueued < kept) {
+        num_enqueued += rte_ring_enqueue_burst(
+            inbound_ring_, (void **)(bufs + num_enqueued),
+            kept - num_enqueued, nullptr);
+        if (num_enqueued < kept)
+          rte_pause();
+      }
+      stats::local().rx_pkts += kept;
+      return;
+    }
+
+    // Compact as we go: only valid, unfragmented frames claim a recycled
+    // Payload slot, so the tail enqueues exactly what was delivered —
+    // fragments are delivered by reassemble() as a Message, not here
+    uint16_t kept = 0;
+    for (uint16_t i = 0; i < nb_rx; ++i) {
+      if (i + 2 < nb_rx)
+        rte_prefetch0(rte_pktmbuf_mtod(bufs[i + 2], void *));
+      struct rte_mbuf *m = bufs[i];
+      FrameView rcv = parse_frame(m);
+      if (!rcv.ok || rcv.opcode != OPCODE_DATA) {
+        rte_pktmbuf_free(m);
+        continue;
+      }
 
-        rx_payloads_ptr_buf[i]->size = rcv.payload_len;
-        // printf("rx_payloads_ptr_buf[i]->size: %d\n",
-        //        rx_payloads_ptr_buf[i]->size);
+      // Learn peer MAC from frame src
+      struct rte_ether_hdr *eth = rte_pktmbuf_mtod(m, struct rte_ether_hdr *);
+      if (!have_learned_peer_.load(std::memory_order_relaxed))
+        learn_peer(eth);
 
-        // No sequence checking - accept all packets
-        // auto payload = rx_payloads_buf[rx_payloads_buf_idx_++ % BURST_SIZE];
-        // if (payload) {
-        //   // payload->size = rcv.payload_len;
-        //   // rte_memcpy(payload->data, rcv.payload, payload->size);
-        // }
+      if (rcv.frag_total > 1) {
+        // Fragment of a large message; park it in the reassembly table
+        reassemble(q, rcv);
         rte_pktmbuf_free(m);
+        continue;
       }
+
+      if (cfg_.hw_timestamp && (m->ol_flags & hwts_rx_flag_) &&
+          rcv.payload_len >= 16) {
+        // Wire latency: peer NIC TX stamp (payload bytes 8..15) to our NIC
+        // RX stamp — no software queueing on either side
+        uint64_t tx_ns;
+        rte_memcpy(&tx_ns, rcv.payload + 8, sizeof(tx_ns));
+        uint64_t rx_ns = hw_rx_timestamp(m);
+        if (tx_ns != 0 && rx_ns > tx_ns)
+          stats::local().wire_ns.record(rx_ns - tx_ns);
+      }
+
+      // No sequence checking - accept all packets
+      q.rx_payloads_ptr_buf[kept++]->size = rcv.payload_len;
+      rte_pktmbuf_free(m);
     }
 
-    if (nb_rx > 0) {
+    if (kept > 0) {
+      stats::LcoreStats &ls = stats::local();
       uint32_t num_enqueued = 0;
-      while ((num_enqueued += rte_ring_sp_enqueue_burst(
-                  inbound_ring_, (void **)rx_payloads_ptr_buf.data(),
-                  nb_rx - (uint16_t)num_enqueued, nullptr)) < nb_rx) {
-        num_rx_trials_++;
+      while ((num_enqueued += rte_ring_enqueue_burst(
+                  inbound_ring_, (void **)q.rx_payloads_ptr_buf.data(),
+                  kept - (uint16_t)num_enqueued, nullptr)) < kept) {
+        ls.ring_full++;
         if (num_enqueued == 0) {
           rte_pause();
         }
       }
-      num_rx_trials_++;
-      num_rx_hit_++;
-
-      if (num_rx_hit_ % 100000 == 0) {
-        printf("rx hit: %f\n", (double)num_rx_hit_ / num_rx_trials_);
-      }
+      ls.rx_pkts += kept;
     }
   }
 
@@ -235,87 +971,223 @@ public:
       rte_ring_free(inbound_ring_);
     if (outbound_ring_)
       rte_ring_free(outbound_ring_);
+    if (inline_ring_)
+      rte_ring_free(inline_ring_);
+    if (payload_pool_)
+      rte_mempool_free(payload_pool_);
     if (rx_mbuf_pool_)
       rte_mempool_free(rx_mbuf_pool_);
-    if (tx_mbuf_pool_)
-      rte_mempool_free(tx_mbuf_pool_);
+    for (auto *pool : tx_mbuf_pools_)
+      if (pool)
+        rte_mempool_free(pool);
   }
 
 private:
-  struct rte_mbuf *build_data_frame(const rte_ether_addr *dst_mac,
-                                    Payload *payload, uint32_t seq) {
+  // Accumulate a fragment; once all fragments of the message have arrived,
+  // deliver the contiguous Message on the inbound ring. Non-final fragments
+  // are always MAX_PAYLOAD bytes, so frag_idx gives the offset directly.
+  void reassemble(QueueBufs &q, const FrameView &rcv) {
+    // frag_total comes off the wire and sizes the Message allocation; the
+    // sender caps a message at one TX burst, so anything larger is corrupt
+    // or forged — drop it before it drives a multi-hundred-MB rte_malloc
+    if (rcv.frag_total > cfg_.tx_burst_size)
+      return;
+    uint64_t now = rte_get_timer_cycles();
+    QueueBufs::ReasmSlot *slot = nullptr;
+    for (auto &s : q.reasm) {
+      if (s.in_use && s.msg_id == rcv.msg_id) {
+        slot = &s;
+        break;
+      }
+    }
+    if (!slot) {
+      for (auto &s : q.reasm) {
+        if (!s.in_use) {
+          slot = &s;
+          break;
+        }
+        // Age out a stalled message: a lost fragment would otherwise pin
+        // its slot (and its Message allocation) forever, and after
+        // NB_REASM_SLOTS such losses fragmented RX is wedged for good
+        if (now - s.last_frag_cycles > reasm_timeout_cycles_) {
+          rte_free(s.msg);
+          rte_free(s.seen);
+          s.msg = nullptr;
+          s.seen = nullptr;
+          s.in_use = false;
+          slot = &s;
+          break;
+        }
+      }
+      if (!slot)
+        return; // table full; drop (URP is lossy by design)
+      slot->msg = (Message *)rte_malloc(
+          NULL, sizeof(Message) + (size_t)rcv.frag_total * max_payload_,
+          RTE_CACHE_LINE_SIZE);
+      slot->seen = (uint64_t *)rte_zmalloc(
+          NULL, (((size_t)rcv.frag_total + 63) / 64) * sizeof(uint64_t), 0);
+      if (!slot->msg || !slot->seen) {
+        rte_free(slot->msg);
+        rte_free(slot->seen);
+        slot->msg = nullptr;
+        slot->seen = nullptr;
+        stats::local().alloc_failures++;
+        return;
+      }
+      slot->in_use = true;
+      slot->msg_id = rcv.msg_id;
+      slot->total = rcv.frag_total;
+      slot->received = 0;
+      slot->len = 0;
+      slot->last_frag_cycles = now;
+    }
+
+    if (rcv.frag_idx >= slot->total)
+      return;
+    uint64_t &word = slot->seen[rcv.frag_idx >> 6];
+    uint64_t bit = 1ull << (rcv.frag_idx & 63);
+    if (word & bit)
+      return; // duplicate fragment (retransmit or dup impairment)
+    word |= bit;
+    slot->last_frag_cycles = now;
+    rte_memcpy(slot->msg->data + (size_t)rcv.frag_idx * max_payload_,
+               rcv.payload, rcv.payload_len);
+    slot->len += rcv.payload_len;
+    slot->received++;
+
+    if (slot->received == slot->total) {
+      slot->msg->size = slot->len;
+      while (rte_ring_enqueue(inbound_ring_, slot->msg) != 0) {
+        rte_pause();
+      }
+      slot->in_use = false;
+      slot->msg = nullptr;
+      rte_free(slot->seen);
+      slot->seen = nullptr;
+    }
+  }
+
+  // Write the caller's header-template image (the per-queue copy with dst
+  // already patched) into a pre-allocated mbuf and patch the per-frame
+  // fields (seq, payload_len)
+  void fill_data_frame(struct rte_mbuf *m, Payload *payload, uint32_t seq,
+                       const uint8_t *hdr_template) {
     size_t frame_len =
         sizeof(struct rte_ether_hdr) + sizeof(urp_hdr) + payload->size;
-    struct rte_mbuf *m = rte_pktmbuf_alloc(tx_mbuf_pool_);
-    if (!m)
-      panic("Failed to allocate mbuf");
-
     rte_pktmbuf_reset_headroom(m);
     char *data = rte_pktmbuf_append(m, frame_len);
-    if (!data) {
-      rte_pktmbuf_free(m);
+    if (!data)
       panic("Failed to append mbuf");
-    }
-
-    uint8_t *data2 = rte_pktmbuf_mtod(m, uint8_t *);
-    struct rte_ether_hdr *eth = (struct rte_ether_hdr *)data;
-    rte_ether_addr_copy(dst_mac, &eth->dst_addr);
-    rte_ether_addr_copy(&src_mac_, &eth->src_addr);
-    eth->ether_type = rte_cpu_to_be_16(ETH_TYPE);
 
-    urp_hdr *uh = (urp_hdr *)(eth + 1);
-    uh->version = rte_cpu_to_be_16(1);
-    uh->opcode = rte_cpu_to_be_16(OPCODE_DATA);
+    rte_memcpy(data, hdr_template, sizeof(tx_hdr_template_));
+    urp_hdr *uh = (urp_hdr *)((struct rte_ether_hdr *)data + 1);
     uh->seq = rte_cpu_to_be_32(seq);
     uh->payload_len = rte_cpu_to_be_16(payload->size);
     // if (payload->size > 0) {
     //   rte_memcpy(uh->payload, payload->data, payload->size);
     // }
-    return m;
+    if (cfg_.hw_timestamp && payload->size >= 16) {
+      // The staging copy above is elided, so a producer-side stamp never
+      // reaches the wire; stamp the frame itself with NIC PTP time in
+      // payload bytes 8..15 for the peer's wire-latency histogram. One
+      // PTP register read per frame — hw_timestamp is a measurement mode.
+      uint64_t ns = ptp_time_ns();
+      rte_memcpy(uh->payload + 8, &ns, sizeof(ns));
+    }
   }
 
-  urp_hdr parse_frame(struct rte_mbuf *m) {
-    urp_hdr hdr{};
-    uint8_t *data = rte_pktmbuf_mtod(m, uint8_t *);
-    size_t data_len = rte_pktmbuf_pkt_len(m);
-    // printf("data_len: %u\n", data_len);
-    if (data_len < sizeof(urp_hdr) + sizeof(struct rte_ether_hdr))
-      panic("Frame is too small");
-
-    struct rte_ether_hdr *eth = (struct rte_ether_hdr *)data;
+  // Validate and decode a frame in place: the fields come back in host order
+  // and payload points into the mbuf, so the hot loop never copies a header
+  FrameView parse_frame(struct rte_mbuf *m) {
+    FrameView v{};
+    if (rte_pktmbuf_pkt_len(m) <
+        sizeof(struct rte_ether_hdr) + sizeof(urp_hdr))
+      return v;
 
+    struct rte_ether_hdr *eth = rte_pktmbuf_mtod(m, struct rte_ether_hdr *);
     urp_hdr *uh = (urp_hdr *)(eth + 1);
-    hdr.seq = rte_be_to_cpu_32(uh->seq);
-    hdr.version = rte_be_to_cpu_16(uh->version);
-    hdr.opcode = rte_be_to_cpu_16(uh->opcode);
-    hdr.payload_len = rte_be_to_cpu_16(uh->payload_len);
-
-    if (hdr.payload_len > MAX_PAYLOAD)
-      hdr.payload_len = MAX_PAYLOAD;
-    if (hdr.payload_len > 0) {
-      // rte_memcpy(hdr.payload, uh->payload, hdr.payload_len);
-    }
-    return hdr;
+
+    // Fold the validity compares into one flag instead of a branch per field
+    bool ok = eth->ether_type == rte_cpu_to_be_16(ETH_TYPE);
+    ok &= rte_be_to_cpu_16(uh->version) == 1;
+    v.payload_len = rte_be_to_cpu_16(uh->payload_len);
+    ok &= v.payload_len <= max_payload_;
+    v.ok = ok;
+
+    v.seq = rte_be_to_cpu_32(uh->seq);
+    v.opcode = rte_be_to_cpu_16(uh->opcode);
+    v.msg_id = rte_be_to_cpu_32(uh->msg_id);
+    v.frag_idx = rte_be_to_cpu_16(uh->frag_idx);
+    v.frag_total = rte_be_to_cpu_16(uh->frag_total);
+    v.payload = uh->payload;
+    return v;
+  }
+
+  // NIC RX timestamp (ns on the port's PTP clock) from the mbuf dynfield
+  static uint64_t hw_rx_timestamp(const struct rte_mbuf *m) {
+    return *RTE_MBUF_DYNFIELD(m, hwts_offset_, const rte_mbuf_timestamp_t *);
   }
 
+  // Dynfield registered once per process for all hw_timestamp endpoints
+  static inline int hwts_offset_ = -1;
+  static inline uint64_t hwts_rx_flag_ = 0;
+
   uint64_t id = 0;
   uint32_t num_trials = 0;
 
-  uint32_t num_rx_trials_{0};
-  uint32_t num_rx_hit_{0};
-
   rte_ring *inbound_ring_{nullptr};
   rte_ring *outbound_ring_{nullptr};
+  // Small-message ring with inline byte slots (null unless
+  // cfg_.inline_size > 0); see send_inline()/tx_inline()
+  rte_ring *inline_ring_{nullptr};
+  uint32_t inline_esize_{0};
+
+  // Next member port for a TX burst, shared by all queue workers
+  uint32_t next_tx_port() {
+    if (ports_.size() == 1)
+      return 0;
+    return tx_port_rr_.fetch_add(1, std::memory_order_relaxed) %
+           (uint32_t)ports_.size();
+  }
 
   EndpointConfig cfg_;
-  struct rte_mempool *tx_mbuf_pool_{nullptr};
+  // Member ports of the aggregate (just cfg_.port_id when not aggregating)
+  std::vector<uint16_t> ports_;
+  std::atomic<uint32_t> tx_port_rr_{0};
+  // Shared PRNG state: run impairment benchmarks single-queue
+  Impairment impair_;
+  // One TX pool per port and queue (see ctor); indexed
+  // port_idx * nb_queues + queue_id
+  std::vector<struct rte_mempool *> tx_mbuf_pools_;
   struct rte_mempool *rx_mbuf_pool_{nullptr};
+  struct rte_mempool *payload_pool_{nullptr};
   rte_ether_addr src_mac_{};
   rte_ether_addr peer_mac_default_{};
   rte_ether_addr learned_peer_{};
 
-  uint32_t tx_seq_{0}; // Sequence number for outgoing packets
-  bool have_learned_peer_{false};
+  // Pristine ether+urp header image built once in the ctor; each queue
+  // works from its own copy in QueueBufs, this one is never patched again
+  uint8_t tx_hdr_template_[sizeof(struct rte_ether_hdr) + sizeof(urp_hdr)]{};
+
+  std::atomic<uint32_t> tx_seq_{0}; // Sequence number for outgoing packets
+  std::atomic<uint32_t> next_msg_id_{0}; // Fragmented-message ids (never 0)
+  size_t max_payload_{MAX_PAYLOAD}; // Runtime per-frame payload cap
+  uint64_t reasm_timeout_cycles_{0}; // Reassembly slot age-out threshold
+  // One-time publish of the learned peer MAC: an RX worker claims the
+  // write, TX readers acquire the flag before touching learned_peer_
+  std::atomic<bool> have_learned_peer_{false};
+  std::atomic<bool> peer_learn_claim_{false};
+
+  // Learn the peer's MAC from an inbound frame, exactly once across all RX
+  // workers; losers of the claim leave the published address alone
+  void learn_peer(const struct rte_ether_hdr *eth) {
+    bool expected = false;
+    if (!peer_learn_claim_.compare_exchange_strong(expected, true,
+                                                   std::memory_order_relaxed))
+      return;
+    rte_ether_addr_copy(&eth->src_addr, &learned_peer_);
+    have_learned_peer_.store(true, std::memory_order_release);
+  }
 };
 
 } // namespace urp
@@ -5,10 +5,14 @@
 #include <rte_eal.h>
 #include <rte_ether.h>
 #include <rte_ring.h>
-#include <rte_ring_peek_zc.h>
 #include <thread>
 
 #include "arg.hpp"
+#include "backoff.hpp"
+#include "dpdk-rte-ring.hpp"
+#include "event-pipeline.hpp"
+#include "numa.hpp"
+#include "stats.hpp"
 #include "urp.hpp"
 #include <argparse/argparse.hpp>
 
@@ -19,79 +23,84 @@ using namespace urp;
 static int responder_thread_main(void *arg) {
   // Optional: echo payloads back to sender as a demonstration of duplex
   URPEndpoint *ep = reinterpret_cast<URPEndpoint *>(arg);
-  rte_ring *in = ep->inbound_ring();
-  rte_ring *out = ep->outbound_ring();
+  auto in = srp::DpdkRteRing<Payload>::view(ep->inbound_ring());
+  auto out = srp::DpdkRteRing<Payload>::view(ep->outbound_ring());
 
-  uint64_t last_time = 0;
-  uint64_t total_count = 0;
-  uint64_t last_count = 0;
   uint64_t count = 0;
-  double avg_count = 0;
-  double num;
-  const uint64_t report_interval = 1000000; // report every 1M packets
   const uint32_t burst_size = 1024;
   Payload *msg[burst_size];
   for (uint32_t i = 0; i < burst_size; ++i) {
-    msg[i] = (Payload *)rte_zmalloc(NULL, sizeof(Payload), RTE_CACHE_LINE_SIZE);
+    msg[i] = ep->payload_alloc();
+    if (!msg[i])
+      rte_exit(EXIT_FAILURE, "Failed to allocate responder payloads\n");
   }
-  struct rte_ring_zc_data zcd;
-  size_t counter = 0;
-  size_t counter_hit = 0;
+  srp::DpdkRteRing<Payload>::ZcView zcv;
+  stats::LcoreStats &ls = stats::local();
+  IdleBackoff backoff(ep->cfg().adaptive_poll);
   while (true) {
-    counter++;
-    if ((count = rte_ring_dequeue_zc_burst_start(in, burst_size, &zcd,
-                                                 nullptr)) > 0) {
-
-      total_count += count;
-      if (total_count - last_count > report_interval) {
-        uint64_t now = rte_get_tsc_cycles();
-        double seconds = (now - last_time) / (double)rte_get_tsc_hz();
-        uint64_t delta = total_count - last_count;
-        double throughput = delta / seconds;
-        last_time = now;
-        last_count = total_count;
-        printf("throughput: %f, hit: %f\n", throughput,
-               (double)counter_hit / counter);
-      }
+    if ((count = in.zc_dequeue_start(burst_size, zcv)) > 0) {
+
+      ls.rx_pkts += count;
 
       uint16_t num_enqueued = 0;
-      uint32_t free_space;
 
-      auto size = ((Payload **)zcd.ptr1)[0]->size;
+      size_t size;
+      if (ep->cfg().zero_copy_rx) {
+        // In this mode the ring slots actually hold rte_mbuf*; read the
+        // payload in place, then hand the mbufs back in bulk
+        auto s1 = zcv.span1();
+        auto s2 = zcv.span2();
+        size = URPEndpoint::payload_view((rte_mbuf *)s1[0]).size();
+        URPEndpoint::rx_release((rte_mbuf **)s1.data(), s1.size());
+        if (!s2.empty())
+          URPEndpoint::rx_release((rte_mbuf **)s2.data(), s2.size());
+      } else {
+        size = zcv.span1()[0]->size;
+      }
 
       for (uint32_t i = 0; i < count; ++i) {
         msg[i]->size = size;
       }
 
-      while ((num_enqueued +=
-              rte_ring_enqueue_burst(out, (void **)msg, count - num_enqueued,
-                                     &free_space)) < count) {
+      while ((num_enqueued += out.enqueue_burst(msg + num_enqueued,
+                                                count - num_enqueued)) <
+             count) {
+        ls.ring_full++;
         rte_pause();
       }
-      counter_hit++;
 
-      rte_ring_dequeue_zc_finish(in, count);
+      in.zc_dequeue_finish(count);
+      backoff.poll(true);
     } else {
-      rte_pause();
+      backoff.poll(false);
     }
   }
   return 0;
 }
 
+struct QueueWorkerArg {
+  URPEndpoint *ep;
+  uint16_t queue_id;
+};
+
 static int tx_thread_main(void *arg) {
-  URPEndpoint *ep = reinterpret_cast<URPEndpoint *>(arg);
-  printf("TX thread running on lcore %u\n", rte_lcore_id());
+  QueueWorkerArg *wa = reinterpret_cast<QueueWorkerArg *>(arg);
+  printf("TX thread for queue %u running on lcore %u\n", wa->queue_id,
+         rte_lcore_id());
+  IdleBackoff backoff(wa->ep->cfg().adaptive_poll);
   for (;;) {
-    ep->tx();
+    backoff.poll(wa->ep->tx(wa->queue_id) != 0);
   }
   return 0;
 }
 
 static int rx_thread_main(void *arg) {
-  URPEndpoint *ep = reinterpret_cast<URPEndpoint *>(arg);
-  printf("RX thread running on lcore %u\n", rte_lcore_id());
+  QueueWorkerArg *wa = reinterpret_cast<QueueWorkerArg *>(arg);
+  printf("RX thread for queue %u running on lcore %u\n", wa->queue_id,
+         rte_lcore_id());
+  IdleBackoff backoff(wa->ep->cfg().adaptive_poll);
   for (;;) {
-    ep->rx();
+    backoff.poll(wa->ep->rx(wa->queue_id) != 0);
   }
   return 0;
 }
@@ -111,22 +120,49 @@ int main(int argc, char **argv) {
   // No default peer; will learn from inbound frames and reply
   memset(&cfg.default_peer_mac, 0, sizeof(cfg.default_peer_mac));
 
+  if (cfg.event_pipeline) {
+    // Event-driven mode: no fixed tx/rx/responder lcores; the parse and
+    // echo stages land on whichever worker the event scheduler picks
+    EventPipeline *pipe = new EventPipeline(cfg);
+    pipe->start();
+    stats::start_reporter("server_stats.csv");
+    for (;;) {
+      rte_pause();
+    }
+    return 0;
+  }
+
   URPEndpoint *ep = new URPEndpoint(cfg);
   if (!ep)
     return 1;
 
-  // Launch a responder thread to echo data back
-  unsigned tx_lcore = rte_get_next_lcore(rte_lcore_id(), 1, 0);
-
-  rte_eal_remote_launch((lcore_function_t *)tx_thread_main, ep, tx_lcore);
-
-  unsigned rx_lcore = rte_get_next_lcore(tx_lcore, 1, 0);
-  rte_eal_remote_launch((lcore_function_t *)rx_thread_main, ep, rx_lcore);
+  // Launch one TX and one RX worker per queue pair
+  static QueueWorkerArg worker_args[RTE_MAX_QUEUES_PER_PORT];
+  // Keep the workers on the NIC's node; next_lcore_on_socket warns when it
+  // has to spill onto the far socket
+  int socket = port_socket_id(cfg.port_id);
+  unsigned lcore = rte_lcore_id();
+  for (uint16_t q = 0; q < cfg.nb_queues; ++q) {
+    worker_args[q] = {ep, q};
+    lcore = next_lcore_on_socket(lcore, socket);
+    if (lcore == RTE_MAX_LCORE)
+      rte_exit(EXIT_FAILURE, "Not enough cores\n");
+    rte_eal_remote_launch((lcore_function_t *)tx_thread_main, &worker_args[q],
+                          lcore);
+    lcore = next_lcore_on_socket(lcore, socket);
+    if (lcore == RTE_MAX_LCORE)
+      rte_exit(EXIT_FAILURE, "Not enough cores\n");
+    rte_eal_remote_launch((lcore_function_t *)rx_thread_main, &worker_args[q],
+                          lcore);
+  }
 
-  unsigned worker_lcore = rte_get_next_lcore(rx_lcore, 1, 0);
+  unsigned worker_lcore = next_lcore_on_socket(lcore, socket);
 
   rte_eal_remote_launch((lcore_function_t *)responder_thread_main, ep,
                         worker_lcore);
+
+  // Reporter aggregates the per-lcore stats blocks off the hot path
+  stats::start_reporter("server_stats.csv");
   for (;;) {
     rte_pause();
   }
@@ -50,4 +50,10 @@ target("client")
 target("server")
     set_kind("binary")
     add_files("server-src/*.cpp", "common/*.cpp")
-    add_packages("argparse")
\ No newline at end of file
+    add_packages("argparse")
+
+-- Single-host microbenchmarks (rings, frame codec, payload pool); no NIC
+-- needed, so ring/codec changes can be checked without a bench.zsh run
+target("bench")
+    set_kind("binary")
+    add_files("bench-src/*.cpp")
\ No newline at end of file